@@ -50,6 +50,12 @@ public:
     /// @return Vector of all books
     [[nodiscard]] std::vector<models::Book> findAll(bool availableOnly = false) const;
 
+    /// Get one page of all books, ordered by title (then ID)
+    /// @param offset Number of books to skip
+    /// @param limit Maximum number of books to return
+    /// @return Up to limit books starting at position offset
+    [[nodiscard]] std::vector<models::Book> findPage(int64_t offset, int64_t limit) const;
+
     /// Update an existing book
     /// @param book Book with updated data (id must be set)
     /// @return true if the book was updated, false if not found
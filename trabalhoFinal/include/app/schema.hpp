@@ -61,6 +61,12 @@ constexpr std::string_view kCreateStudentActiveIndex = R"sql(
     ON students(active);
 )sql";
 
+/// Index on book titles, so listing books a page at a time does not sort the whole table
+constexpr std::string_view kCreateBookTitleIndex = R"sql(
+    CREATE INDEX IF NOT EXISTS idx_books_title 
+    ON books(title);
+)sql";
+
 /// Index on loans by student
 constexpr std::string_view kCreateLoanStudentIndex = R"sql(
     CREATE INDEX IF NOT EXISTS idx_loans_student 
@@ -38,6 +38,8 @@ protected:
         int x = tui.cols / 2 - w / 2;
         int y = tui.rows / 2 - h / 2;
         auto* c = new container({x, y}, {w, h}, defaultModalStyle(), title);
+        c->setPercentPosition(50, 50); // stays centered across resizes
+        c->setAnchors(element::AnchorX::Center, element::AnchorY::Middle);
         c->setZIndex(zIndex);
         c->setDefaultElementStyle(defaultModalStyle());
         c->setInheritStyle(true);
@@ -57,10 +57,25 @@ std::string getFutureISODate(int daysAhead);
 
 //data loaders
 std::vector<std::string> loadStudentsFromDatabase(app::repos::StudentRepository& repo);
-std::vector<std::string> loadBooksFromDatabase(app::repos::BookRepository& repo);
 std::vector<std::string> searchBooksFromDatabase(app::repos::BookRepository& repo, const std::string& query);
 std::vector<RichListItem> loadLoansRichFromDatabase(app::repos::LoanRepository& repo);
 
+// Rows of the books view, read a page at a time as the list scrolls (ListView::setSource), so a
+// large catalogue opens without loading every title
+class BookListSource : public ListDataSource {
+public:
+    explicit BookListSource(app::repos::BookRepository& repo) : repo(repo) {}
+    int count() override;
+    void itemAt(int i, std::string& out) override;
+    void prefetch(int first, int n) override;
+
+private:
+    app::repos::BookRepository& repo;
+    bool empty = false;
+    int pageFirst = 0;
+    std::vector<app::models::Book> page; // rows [pageFirst, pageFirst + page.size())
+};
+
 
 extern NotificationManager* globalNotifications;
 inline void notifyInfo(const std::string& msg) {
@@ -1,8 +1,17 @@
 #include "chrmaTUI.hpp"
 
 struct termios originalTermios;
+// How long pollInput waits for the rest of an escape sequence before taking a lone ESC
+static const int kEscapeWaitMs = 10;
 // Resolve percent/anchor layout into absolute position and size each frame
 void element::applyLayoutForFrame(TUImanager& tui) {
+    const rect parentRect = parent ? rect{parent->position.x, parent->position.y, parent->size.x, parent->size.y} : rect{};
+    if (layoutValid && parentRect == layoutParent && layoutCols == tui.cols && layoutRows == tui.rows) return;
+    layoutValid = true;
+    layoutParent = parentRect;
+    layoutCols = tui.cols;
+    layoutRows = tui.rows;
+
     const LayoutSpec& L = layout;
     int baseX = 0, baseY = 0, availW = tui.cols, availH = tui.rows;
     if (parent) {
@@ -53,6 +62,22 @@ void element::applyLayoutForFrame(TUImanager& tui) {
     if (L.usePercentH) size.y = ph;
 }
 
+void element::onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) {
+    const uint8_t state = userState;
+    for (int i = 0; i < count && userState == state; ++i) onInteract(key, 0, userState, tui);
+}
+
+void element::onPaste(const char* text, size_t len, uint8_t& userState, TUImanager& tui) {
+    // A newline in pasted text is not Enter: every byte goes in as a plain character
+    const uint8_t state = userState;
+    for (size_t i = 0; i < len && userState == state; ++i) onInteract(UNKNOWN, text[i], userState, tui);
+}
+
+void element::invalidate() {
+    dirty = true;
+    if (parent) parent->childInvalidated();
+}
+
 void disableRawMode(){
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &originalTermios);
 }
@@ -65,10 +90,22 @@ void enableRawMode(){
     raw.c_cflag |= CS8;
     raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
     raw.c_cc[VMIN] = 0;
-    raw.c_cc[VTIME] = 1;
+    raw.c_cc[VTIME] = 0; // never block in read(); waiting happens in TUImanager::waitEvents
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);    
 }
 
+static int originalStdoutFlags = -1;
+void restoreBlockingOutput(){
+    if (originalStdoutFlags != -1) fcntl(STDOUT_FILENO, F_SETFL, originalStdoutFlags);
+}
+void enableNonBlockingOutput(){
+    int flags = fcntl(STDOUT_FILENO, F_GETFL);
+    if (flags == -1 || (flags & O_NONBLOCK)) return;
+    if (originalStdoutFlags == -1) atexit(restoreBlockingOutput);
+    originalStdoutFlags = flags;
+    fcntl(STDOUT_FILENO, F_SETFL, flags | O_NONBLOCK);
+}
+
 void getTerminalSize(int& rows, int& cols) {
     struct winsize ws;
     if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
@@ -81,46 +118,202 @@ void getTerminalSize(int& rows, int& cols) {
     }
 }
 
+namespace {
+int winchFd = -1;
+int resizeHandlerUsers = 0;
+sigset_t previousMask;
+}
+
+void installResizeHandler() {
+    if (resizeHandlerUsers++ > 0) return;
+    sigset_t winch;
+    sigemptyset(&winch);
+    sigaddset(&winch, SIGWINCH);
+    pthread_sigmask(SIG_BLOCK, &winch, &previousMask);
+    winchFd = signalfd(-1, &winch, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+void removeResizeHandler() {
+    if (resizeHandlerUsers == 0 || --resizeHandlerUsers > 0) return;
+    if (winchFd >= 0) close(winchFd);
+    winchFd = -1;
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+}
+
+bool takeResizeSignal() {
+    signalfd_siginfo info;
+    bool got = false;
+    while (winchFd >= 0 && read(winchFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) got = true;
+    return got;
+}
+
+int resizeSignalFd() {
+    return winchFd;
+}
+
+repeatSupport detectRepeatSupport() {
+    if (const char* force = std::getenv("CHRMATUI_REP")) {
+        if (std::strcmp(force, "any") == 0) return repeatAny;
+        if (std::strcmp(force, "ascii") == 0) return repeatAscii;
+        return repeatNone;
+    }
+    const char* term = std::getenv("TERM");
+    if (!term) return repeatNone;
+    if (std::strncmp(term, "tmux", 4) == 0 || std::getenv("TMUX")) return repeatAscii;
+    // The linux console, screen and old hardware terminals print REP's argument as text or ignore it
+    static const char* const full[] = {"xterm", "foot", "alacritty", "wezterm", "contour", "st-"};
+    for (const char* prefix : full) {
+        if (std::strncmp(term, prefix, std::strlen(prefix)) == 0) return repeatAny;
+    }
+    return repeatNone;
+}
+
+colorDepth detectColorDepth() {
+    if (const char* force = std::getenv("CHRMATUI_COLORS")) {
+        if (std::strcmp(force, "16") == 0) return depth16;
+        if (std::strcmp(force, "256") == 0) return depth256;
+        return depthTrueColor;
+    }
+    const char* term = std::getenv("TERM");
+    if (!term) return depthTrueColor;
+    size_t len = std::strlen(term);
+    auto endsWith = [&](const char* suffix) {
+        size_t n = std::strlen(suffix);
+        return len >= n && std::strcmp(term + len - n, suffix) == 0;
+    };
+    if (std::strcmp(term, "linux") == 0 || std::strcmp(term, "ansi") == 0 || std::strncmp(term, "vt", 2) == 0 ||
+        endsWith("-16color") || endsWith("-8color")) {
+        return depth16;
+    }
+    return depthTrueColor;
+}
+
+bool detectSyncSupport() {
+    if (const char* force = std::getenv("CHRMATUI_SYNC")) return force[0] == '1';
+    const char* term = std::getenv("TERM");
+    return !(term && std::strcmp(term, "linux") == 0);
+}
+
+scrollSupport detectScrollSupport() {
+    if (const char* force = std::getenv("CHRMATUI_SCROLL")) {
+        if (std::strcmp(force, "margins") == 0) return scrollMargins;
+        if (std::strcmp(force, "rows") == 0) return scrollRows;
+        return scrollNone;
+    }
+    if (std::getenv("XTERM_VERSION") && !std::getenv("TMUX")) return scrollMargins;
+    return scrollRows;
+}
+
+void ttyBackend::open(frameEncoder::options& opts) {
+    enableRawMode();
+    std::setbuf(stdout, nullptr);  // Disable stdio buffering
+    installResizeHandler();
+    opts.repeatRuns = detectRepeatSupport();
+    opts.depth = detectColorDepth();
+    opts.syncUpdates = detectSyncSupport();
+    opts.scrolls = detectScrollSupport();
+    std::cout << "\x1b[?25l\x1b[?2004h" << std::flush; // hide cursor, bracketed paste on
+    enableNonBlockingOutput();
+}
+
+void ttyBackend::close() {
+    removeResizeHandler();
+    restoreBlockingOutput();
+    disableRawMode();
+    std::cout << "\x1b[?2004l\x1b[?25h\x1b[0m\x1b[2J\x1b[H" << std::flush;
+}
+
+void ttyBackend::getSize(int& rows, int& cols) {
+    getTerminalSize(rows, cols);
+}
+
+int ttyBackend::resizeFd() {
+    return resizeSignalFd();
+}
+
+bool ttyBackend::takeResize() {
+    return takeResizeSignal();
+}
+
+void TUImanager::attach(terminalBackend& backend) {
+    term = &backend;
+    encoder.styles = &styles;
+    costEncoder.styles = &styles;
+    term->open(encoder.opts);
+    term->getSize(rows, cols);
+    resize(rows, cols);
+    initEventLoop();
+    if (const char* hud = std::getenv("CHRMATUI_HUD")) hudOn = hud[0] == '1';
+    userState = NAVIGATING;
+}
+
+void TUImanager::resize(int newRows, int newCols) {
+    newRows = std::max(1, newRows);
+    newCols = std::max(1, newCols);
+    std::vector<cell> resized(static_cast<size_t>(newRows) * static_cast<size_t>(newCols), cell{});
+    // Keep what was drawn on the base layer where the old and new screens overlap. Surfaces keep
+    // their cells and are clipped to the new screen; the composite is rebuilt from scratch.
+    const int keepRows = std::min(rows, newRows), keepCols = std::min(cols, newCols);
+    for (int y = 0; y < keepRows && !baseLayer.empty(); ++y) {
+        std::memcpy(&resized[static_cast<size_t>(y) * newCols], &baseLayer[static_cast<size_t>(y) * cols],
+                    static_cast<size_t>(keepCols) * sizeof(cell));
+    }
+    rows = newRows;
+    cols = newCols;
+    baseLayer.swap(resized);
+    screenBuffer.assign(baseLayer.size(), cell{});
+    backRowHash.assign(rows, 0);
+    for (int y = 0; y < rows; ++y) recomputeRowHash(y);
+    damageLo.assign(rows, 0);
+    damageHi.assign(rows, cols);
+    retarget();
+    invalidateFront();
+    // Room for a full repaint with occasional color changes; the arena grows if a frame needs more
+    encoder.out.reserve(screenBuffer.size() * 16 + 64);
+    encoder.setScreenSize(cols, rows);
+    rowScratch.assign(static_cast<size_t>(cols) * 3, 0);
+    styleScratch.assign(static_cast<size_t>(cols), 0);
+    scrollHints.clear();
+    pendingChanges = true;
+    invalidateAllContainers();
+}
+
+bool TUImanager::checkResize() {
+    if (!term->takeResize()) return false;
+    int newRows = rows, newCols = cols;
+    term->getSize(newRows, newCols);
+    if (newRows == rows && newCols == cols) return false;
+    resize(newRows, newCols);
+    return true;
+}
+
 void TUImanager::clearScreen(color col) {
     // Reset internal buffer to printable spaces with provided background
-    color fg = {0, 0, 0, 255};
-    // All cells become dirty after clear
-    dirtyCount = static_cast<size_t>(rows) * static_cast<size_t>(cols);
-    for (int y = 0; y < rows; ++y) {
-        for (int x = 0; x < cols; ++x) {
-            // Use a printable space so render() emits a colored cell instead of skipping it
-            characterSpace cell{};
-            cell.character = ' ';
-            cell.colorForeground = fg;
-            cell.colorBackground = col;
-            cell.z = 0;
-            cell.utf8.clear();
-            screenBuffer[y][x] = cell;
-            dirty[y][x] = 1;
-        }
-    }
+    // Use a printable space so render() emits a colored cell instead of skipping it
+    cell blank{};
+    blank.glyph[0] = ' ';
+    blank.glyphLen = 1;
+    blank.style = styleOf(packColor({0, 0, 0, 255}), packColor(col));
+    blank.z = 0;
+    std::fill(baseLayer.begin(), baseLayer.end(), blank);
+    damageRect({0, 0, cols, rows});
 }
 
 // Clear a rectangular region (width x height) starting at x,y with background color bg.
-// This writes space glyphs into the internal buffer and marks cells dirty so render() will update the terminal.
+// This writes space glyphs into the back buffer; render() will update whatever differs on the terminal.
 void TUImanager::clearRect(int x, int y, int width, int height, color bg) {
     if (width <= 0 || height <= 0) return;
-    int startX = std::max(0, x);
-    int startY = std::max(0, y);
-    int endX = std::min(cols, x + width);
-    int endY = std::min(rows, y + height);
-    color fg = {0,0,0,255};
+    if (!clipRect(x, y, width, height)) return;
+    const int startX = x, startY = y, endX = x + width, endY = y + height;
+    track(startX, startY, width, height);
+    cell blank{};
+    blank.glyph[0] = ' ';
+    blank.glyphLen = 1;
+    blank.style = styleOf(packColor({0, 0, 0, 255}), packColor(bg));
+    blank.z = 0;
     for (int yy = startY; yy < endY; ++yy) {
-        for (int xx = startX; xx < endX; ++xx) {
-            characterSpace cell{};
-            cell.character = ' ';
-            cell.colorForeground = fg;
-            cell.colorBackground = bg;
-            cell.z = 0;
-            cell.utf8.clear();
-            screenBuffer[yy][xx] = cell;
-            if (!dirty[yy][xx]) { dirty[yy][xx] = 1; ++dirtyCount; }
-        }
+        std::fill(targetRow(yy) + startX, targetRow(yy) + endX, blank);
+        damage(yy, startX, endX);
     }
 }
 
@@ -134,93 +327,70 @@ pressedKey mapCharToKey(char c){
 }
 
 bool TUImanager::pollInput() {
-    char c = '\0';
-    int nread = read(STDIN_FILENO, &c, 1);
-
-    if (nread == -1 && errno != EAGAIN) return true; // Handle read error
-
-    if (nread > 0) {
-        pressedKey key = UNKNOWN;
-
-        if (c == '\x1b') { // Escape sequence
-            // Read the rest of the sequence non-blocking up to a short limit
-            char buf[32];
-            int bi = 0;
-            // Try to read up to buf size or until a likely terminator is seen
-            for (int i = 0; i < 31; ++i) {
-                int r = read(STDIN_FILENO, &buf[bi], 1);
-                if (r != 1) break;
-                char ch = buf[bi];
-                bi++;
-                // Common terminators for CSI sequences: letters and tilde
-                if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || ch == '~') break;
-            }
-            
-            if (bi == 0) {
-                // No additional bytes read - this is a standalone ESC key
-                key = ESC;
-            } else {
-                std::string seq(buf, buf + bi);
-                if (!seq.empty() && seq[0] == '[') {
-                    // Simple arrow keys (CSI A/B/C/D)
-                    if (bi >= 2 && (seq[1] == 'A' || seq[1] == 'B' || seq[1] == 'C' || seq[1] == 'D')) {
-                        switch (seq[1]) {
-                            case 'A': key = UP; break;
-                            case 'B': key = DOWN; break;
-                            case 'C': key = RIGHT; break;
-                            case 'D': key = LEFT; break;
-                        }
-                    } else {
-                        // Look for various Shift+Enter patterns
-                        // Common patterns: "13;2u", "13;2~", "1;2M" (some terminals), "13:2u" (kitty)
-                        if (seq.find("13;2u") != std::string::npos || 
-                            seq.find("13;2~") != std::string::npos ||
-                            seq.find("13:2u") != std::string::npos ||
-                            seq.find("1;2M") != std::string::npos) {
-                            key = SHIFT_ENTER;
-                        }
-                    }
-                }
-            }
-        } else {
-            key = mapCharToKey(c);
-        }
+    auto start = std::chrono::steady_clock::now();
+    input.beginBatch();
+    const int inFd = term->inputFd();
+    if (!input.drain(inFd)) return true; // read error
+    // Reads do not block (VTIME=0): give a sequence split across packets a moment
+    while (input.midSequence()) {
+        struct pollfd pfd{inFd, POLLIN, 0};
+        if (poll(&pfd, 1, kEscapeWaitMs) != 1) { input.flushPending(); break; }
+        if (!input.drain(inFd)) return true;
+    }
+    profileCur.inputDecodeUs += usSince(start);
+    start = std::chrono::steady_clock::now();
+    bool close = false;
+    for (const inputEvent& ev : input.events) {
+        if ((close = dispatchInput(ev))) break;
+    }
+    profileCur.inputHandlersUs += usSince(start);
+    return close;
+}
 
-    if (key == Q && userState == NAVIGATING) return true;
+bool TUImanager::dispatchInput(const inputEvent& ev) {
+    const pressedKey key = ev.key;
+    const char c = ev.c;
+    if (key == Q && userState == NAVIGATING && !ev.paste) return true;
+    if (key == UNKNOWN && c == 0x10 && !ev.paste) { setProfilerHud(!hudOn); return false; } // Ctrl+P
 
-        container* current = containerID;
-        element* focusedElem = current ? current->getFocused() : nullptr;
+    container* current = containerID;
+    element* focusedElem = current ? current->getFocused() : nullptr;
 
-        if (!focusedElem) return false;
+    if (!focusedElem) return false;
 
-        if (userState == CAPTURE) {
-            focusedElem->onInteract(key, c, userState, *this);
-            if (userState != CAPTURE) {
-                // Defer the capture-end callback to end of frame so user drawings persist
-                element* endedElem = focusedElem;
-                enqueueEndOfFrame([endedElem](TUImanager& tui){ endedElem->notifyCaptureEnd(tui); });
-            }
-        } else if (userState == NAVIGATING) {
-            if (key == UP || key == DOWN) {
-                if (current) current->navigate(key);
-            } else if (key == LEFT && current && current->getLeftPointer()) {
-                current->getFocused()->notifyHover(*this, false); // Unhover old
-                containerID = current->getLeftPointer();
-                containerID->tui = this;
-                containerID->focusedIndex = 0;
-                if(!containerID->elements.empty()) containerID->getFocused()->notifyHover(*this, true); // hover new
-            } else if (key == RIGHT && current && current->getRightPointer()) {
-                current->getFocused()->notifyHover(*this, false); // Unhover old
-                containerID = current->getRightPointer();
+    if (userState == CAPTURE) {
+        if (ev.paste) {
+            focusedElem->notifyPaste(input.pasted.data() + ev.pasteOffset, ev.pasteLen, userState, *this);
+        } else if (ev.count > 1) {
+            focusedElem->notifyInteractRepeat(key, ev.count, userState, *this);
+        } else {
+            focusedElem->notifyInteract(key, c, userState, *this);
+        }
+        if (userState != CAPTURE) {
+            // Defer the capture-end callback to end of frame so user drawings persist
+            element* endedElem = focusedElem;
+            enqueueEndOfFrame([endedElem](TUImanager& tui){ endedElem->notifyCaptureEnd(tui); });
+        }
+    } else if (userState == NAVIGATING) {
+        if (ev.paste) return false;
+        if (key == UP || key == DOWN) {
+            for (int i = 0; i < ev.count; ++i) current->navigate(key);
+        } else if (key == LEFT || key == RIGHT) {
+            for (int i = 0; i < ev.count; ++i) {
+                container* next = key == LEFT ? containerID->getLeftPointer() : containerID->getRightPointer();
+                if (!next) break;
+                if (containerID->getFocused()) containerID->getFocused()->notifyHover(*this, false); // Unhover old
+                containerID = next;
                 containerID->tui = this;
                 containerID->focusedIndex = 0;
                 if(!containerID->elements.empty()) containerID->getFocused()->notifyHover(*this, true); // hover new
-            } else if (key == ENTER) {
-                if (focusedElem->capturesInput()) {
-                    userState = CAPTURE;
-                } else {
-                    focusedElem->onInteract(key, c, userState, *this);
-                }
+            }
+        } else if (key == ENTER) {
+            if (focusedElem->capturesInput()) {
+                userState = CAPTURE;
+                focusedElem->invalidate(); // capture changes how it is drawn
+            } else {
+                focusedElem->notifyInteract(key, c, userState, *this);
             }
         }
     }
@@ -228,15 +398,7 @@ bool TUImanager::pollInput() {
 }
 
 bool TUImanager::waitForInput(int timeoutMs) {
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(STDIN_FILENO, &readfds);
-    struct timeval tv;
-    tv.tv_sec = timeoutMs / 1000;
-    tv.tv_usec = (timeoutMs % 1000) * 1000;
-    int ret = select(STDIN_FILENO + 1, &readfds, nullptr, nullptr, &tv);
-    if (ret > 0 && FD_ISSET(STDIN_FILENO, &readfds)) return true;
-    return false;
+    return waitEvents(timeoutMs);
 }
 
 bool TUImanager::windowShouldClose() {
@@ -244,173 +406,254 @@ bool TUImanager::windowShouldClose() {
 }
 
 void TUImanager::render() {
-    // Disable line wrap to avoid auto-wrapping the last column into the next line, too stupid to fix this the right way
-    std::cout << "\x1b[?7l";
-    for (int y = 0; y < rows; ++y) {
-        int lastFr = -1, lastFg = -1, lastFb = -1;
-        int lastBr = -1, lastBg = -1, lastBb = -1;
-        int x = 0;
-        while (x < cols) {
-            // Skip clean cells and placeholders
-            while (x < cols) {
-                if (!dirty[y][x]) { ++x; continue; }
-                const characterSpace& cs = screenBuffer[y][x];
-                if (cs.utf8.empty() && cs.character == '\0') { dirty[y][x] = 0; ++x; continue; }
-                break;
-            }
-            if (x >= cols) break;
-
-            // Start of a dirty printable span
-            int startX = x;
-            std::cout << "\x1b[" << (y + 1) << ";" << (startX + 1) << "H";
-
-            std::string out;
-            out.reserve((cols - startX) * 8);
-            while (x < cols && dirty[y][x]) {
-                const characterSpace& cs = screenBuffer[y][x];
-                // Placeholders are cleared and break the span visually (no output)
-                if (cs.utf8.empty() && cs.character == '\0') { if (dirty[y][x]) { dirty[y][x] = 0; if (dirtyCount) --dirtyCount; } break; }
-                // Emit color changes inline in the span buffer
-                if (lastFr != cs.colorForeground.r || lastFg != cs.colorForeground.g || lastFb != cs.colorForeground.b) {
-                    lastFr = cs.colorForeground.r; lastFg = cs.colorForeground.g; lastFb = cs.colorForeground.b;
-                    out += "\x1b[38;2"; out += ";"; out += std::to_string((int)cs.colorForeground.r);
-                    out += ";"; out += std::to_string((int)cs.colorForeground.g);
-                    out += ";"; out += std::to_string((int)cs.colorForeground.b); out += "m";
-                }
-                if (lastBr != cs.colorBackground.r || lastBg != cs.colorBackground.g || lastBb != cs.colorBackground.b) {
-                    lastBr = cs.colorBackground.r; lastBg = cs.colorBackground.g; lastBb = cs.colorBackground.b;
-                    out += "\x1b[48;2"; out += ";"; out += std::to_string((int)cs.colorBackground.r);
-                    out += ";"; out += std::to_string((int)cs.colorBackground.g);
-                    out += ";"; out += std::to_string((int)cs.colorBackground.b); out += "m";
-                }
-                if (!cs.utf8.empty()) out += cs.utf8; else out += cs.character ? std::string(1, cs.character) : std::string(" ");
-                if (dirty[y][x]) { dirty[y][x] = 0; if (dirtyCount) --dirtyCount; }
-                ++x;
-            }
-            std::cout << out;
+    if (hudOn) drawHud();
+    const double composeBefore = profileCur.composeUs, encodeBefore = profileCur.encodeUs, writeBefore = profileCur.writeUs;
+    const auto start = std::chrono::steady_clock::now();
+    renderFrame();
+    // What renderFrame did besides compositing, encoding and writing is the diff
+    profileCur.diffUs += usSince(start) - (profileCur.composeUs - composeBefore) - (profileCur.encodeUs - encodeBefore) -
+                         (profileCur.writeUs - writeBefore);
+    closeProfile();
+    stylesFull = false; // the frame's cells may have let go of some ids
+}
+
+void TUImanager::renderFrame() {
+    lastFrame = renderStats{};
+    if (outputQueued()) {
+        // The terminal has not taken the last frame; everything changed since goes out in one
+        // frame once it has (frontBuffer already counts the queued one)
+        ++outStats.framesSkipped;
+        profileCur.skipped = true;
+        return;
+    }
+    const auto composeStart = std::chrono::steady_clock::now();
+    compose();
+    profileCur.composeUs += usSince(composeStart);
+    pendingChanges = false;
+    frameRows.clear();
+    if (writer.running()) reclaimFrame();
+    auto encodeStart = std::chrono::steady_clock::now();
+    bool started = !scrollHints.empty() && applyScrollHints();
+    profileCur.encodeUs += usSince(encodeStart);
+    // Big frames go to the parallel encoder, which leaves nothing for the serial loop
+    const bool banded = pool.workers() > 0 && encodeBands(started);
+    for (int y = 0; y < rows && !banded; ++y) {
+        // Rows whose content hash matches what the terminal shows are skipped without scanning
+        if (backRowHash[y] == frontRowHash[y]) continue;
+        ++lastFrame.rowsScanned;
+
+        const size_t rowBase = static_cast<size_t>(y) * cols;
+        const cell* back = &screenBuffer[rowBase];
+        encodeStart = std::chrono::steady_clock::now();
+        if (!started) { encoder.beginFrame(); started = true; }
+        lastFrame.cellsEmitted += encoder.encodeRow(back, &frontBuffer[rowBase], y);
+        profileCur.encodeUs += usSince(encodeStart);
+        frameRows.push_back(y);
+        std::memcpy(&frontBuffer[rowBase], back, static_cast<size_t>(cols) * sizeof(cell));
+        frontRowHash[y] = backRowHash[y];
+    }
+    if (!started || (lastFrame.cellsEmitted == 0 && lastFrame.regionsScrolled == 0)) return;
+    encoder.endFrame();
+    lastFrame.bytesEmitted = encoder.out.size();
+    const auto writeStart = std::chrono::steady_clock::now();
+    if (writer.running()) {
+        writer.publish(encoder.out);
+        publishedRows.swap(frameRows);
+    } else {
+        outStats.queuedBytes = encoder.out.size();
+        flushOutput();
+    }
+    profileCur.writeUs += usSince(writeStart);
+    lastEmit = std::chrono::steady_clock::now();
+}
+
+bool TUImanager::flushOutput() {
+    size_t& queued = outStats.queuedBytes;
+    while (queued > 0) {
+        ssize_t w = term->write(encoder.out.data() + encoder.out.size() - queued, queued);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            queued = 0; // the terminal is gone; nothing to retry
+            break;
         }
+        if (static_cast<size_t>(w) < queued) ++outStats.partialWrites;
+        queued -= static_cast<size_t>(w);
+    }
+    outStats.maxQueuedBytes = std::max(outStats.maxQueuedBytes, queued);
+    if (queued > 0 && !watchingOutput) ++outStats.stalls;
+    watchOutput(queued > 0);
+    return queued == 0;
+}
+
+void TUImanager::drainOutput() {
+    while (!flushOutput()) {
+        struct pollfd pfd{term->outputFd(), POLLOUT, 0};
+        if (pfd.fd < 0) break; // a backend that reports EAGAIN without an fd to wait on
+        poll(&pfd, 1, -1);
     }
-    // Reset attributes and restore wrap mode
-    std::cout << "\x1b[0m\x1b[?7h" << std::flush;
+}
+
+outputStats TUImanager::outputBackpressure() const {
+    outputStats stats = outStats;
+    if (writer.running()) writer.addStats(stats);
+    return stats;
+}
+
+void TUImanager::setWriterThread(bool on) {
+    if (!on) { writer.stop(); return; }
+    if (writer.running()) return;
+    drainOutput();
+    committedFront = frontBuffer;
+    committedRowHash = frontRowHash;
+    publishedRows.clear();
+    writer.start(term);
+}
+
+void TUImanager::reclaimFrame() {
+    const bool dropped = writer.retract();
+    for (int y : publishedRows) {
+        if (y >= rows) continue;
+        const size_t rowBase = static_cast<size_t>(y) * cols;
+        const size_t rowBytes = static_cast<size_t>(cols) * sizeof(cell);
+        if (dropped) {
+            std::memcpy(&frontBuffer[rowBase], &committedFront[rowBase], rowBytes);
+            frontRowHash[y] = committedRowHash[y];
+        } else {
+            std::memcpy(&committedFront[rowBase], &frontBuffer[rowBase], rowBytes);
+            committedRowHash[y] = frontRowHash[y];
+        }
+    }
+    publishedRows.clear();
+    if (dropped) {
+        ++lastFrame.framesDropped;
+        ++outStats.framesSkipped;
+    }
+}
+
+bool TUImanager::frameDue() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastEmit);
+    return elapsed.count() >= frameBudgetMs;
+}
+
+int TUImanager::msUntilFrameDue() const {
+    if (outputQueued()) return -1;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastEmit);
+    long long left = frameBudgetMs - elapsed.count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+void TUImanager::recomputeRowHash(int y) {
+    const cell* row = &screenBuffer[static_cast<size_t>(y) * cols];
+    uint64_t h = 0;
+    for (int x = 0; x < cols; ++x) h ^= cellHash(row[x], x);
+    backRowHash[y] = h;
+}
+
+void TUImanager::invalidateFront() {
+    // A style id that is never handed out makes every cell differ
+    cell unknown{};
+    unknown.style = styleUnknown;
+    frontBuffer.assign(screenBuffer.size(), unknown);
+    frontRowHash.resize(rows);
+    for (int y = 0; y < rows; ++y) frontRowHash[y] = ~backRowHash[y];
+    // Nothing is known about the terminal either, whichever frames the writer thread still has
+    committedFront = frontBuffer;
+    committedRowHash = frontRowHash;
+    publishedRows.clear();
+    pendingChanges = true;
 }
 
 characterSpace TUImanager::getCharacter(int x, int y){
-    return this->screenBuffer[y][x];
+    const cell& c = cellAt(x, y);
+    characterSpace cs{};
+    // Single-byte glyphs round-trip through `character`, longer ones through `utf8`
+    cs.character = (c.glyphLen == 1) ? c.glyph[0] : '\0';
+    if (c.glyphLen > 1) cs.utf8.assign(c.glyph, c.glyphLen);
+    cs.colorForeground = unpackColor(styles.fg(c.style));
+    cs.colorBackground = unpackColor(styles.bg(c.style));
+    cs.z = c.z;
+    return cs;
 }
+
 void TUImanager::drawCharacter(characterSpace character, int x, int y) {
-    if (x < 0 || x >= cols || y < 0 || y >= rows) return;
-    const characterSpace& existing = screenBuffer[y][x];
-    int incomingZ = currentZ;
+    if (!character.utf8.empty()) {
+        drawGlyph(character.utf8.data(), static_cast<int>(std::min<size_t>(character.utf8.size(), 4)),
+                  character.colorForeground, character.colorBackground, x, y);
+    } else if (character.character != '\0') {
+        drawGlyph(&character.character, 1, character.colorForeground, character.colorBackground, x, y);
+    } else {
+        drawGlyph(nullptr, 0, character.colorForeground, character.colorBackground, x, y);
+    }
+}
+
+void TUImanager::drawGlyph(const char* utf8, int len, color fg, color bg, int x, int y, int width) {
+    if (x < targetArea.x || x >= targetArea.x + targetArea.w || y < targetArea.y || y >= targetArea.y + targetArea.h) return;
+    track(x, y, 1, 1);
+    cell& existing = targetRow(y)[x];
     // Respect z-order: only draw if we are at or above the existing z
-    if (incomingZ < existing.z) {
+    if (currentZ < existing.z) {
         return;
     }
 
+    cell next{};
+    if (len > 0) {
+        std::memcpy(next.glyph, utf8, static_cast<size_t>(len));
+        next.glyphLen = static_cast<uint8_t>(len);
+        if (width > 1) next.flags = cellWide;
+    }
+    next.z = static_cast<int16_t>(currentZ);
+
     // Compose final background with fast paths
-    color finalBg;
-    uint8_t a = character.colorBackground.a;
+    uint32_t finalBg;
+    uint8_t a = bg.a;
     if (a == 0) {
-        finalBg = existing.colorBackground; // fully transparent => keep old bg
+        finalBg = styles.bg(underneath(existing, x, y).style); // fully transparent => keep old bg
     } else if (a == 255) {
-        finalBg = character.colorBackground; // fully opaque => replace
+        finalBg = packColor(bg); // fully opaque => replace
     } else {
-        float alpha = a / 255.0f;
-        const color& bgOld = existing.colorBackground;
-        const color& bgNew = character.colorBackground;
-        finalBg.r = static_cast<uint8_t>(bgOld.r * (1.0f - alpha) + bgNew.r * alpha);
-        finalBg.g = static_cast<uint8_t>(bgOld.g * (1.0f - alpha) + bgNew.g * alpha);
-        finalBg.b = static_cast<uint8_t>(bgOld.b * (1.0f - alpha) + bgNew.b * alpha);
-        finalBg.a = 255;
+        finalBg = blendPacked(styles.bg(underneath(existing, x, y).style), packColor(bg), a);
     }
-
-    character.colorBackground = finalBg;
-    character.z = incomingZ;
+    next.style = styleOf(packColor(fg), finalBg);
 
     // Skip write if nothing changes
-    bool sameUtf8 = (character.utf8 == existing.utf8);
-    bool sameChar = (character.character == existing.character);
-    bool sameFg = std::memcmp(&character.colorForeground, &existing.colorForeground, sizeof(color)) == 0;
-    bool sameBg = std::memcmp(&character.colorBackground, &existing.colorBackground, sizeof(color)) == 0;
-    bool sameZ = (character.z == existing.z);
-    if (sameUtf8 && sameChar && sameFg && sameBg && sameZ) {
+    if (std::memcmp(&next, &existing, sizeof(cell)) == 0) {
         return;
     }
 
-    screenBuffer[y][x] = character;
-    if (!dirty[y][x]) { dirty[y][x] = 1; ++dirtyCount; }
+    existing = next;
+    damage(y, x, x + 1);
 }
 
 void TUImanager::drawString(const std::string& str, color fg, color bg, int x, int y) {
     if (y < 0 || y >= rows) return;
-    // UTF-8 decode and use wcwidth for display width
-    mbstate_t ps{};
-    const char* s = str.c_str();
+    const char* s = str.data();
     size_t len = str.size();
     int col = x;
     while (len > 0 && col < cols) {
-        wchar_t wc;
-        size_t consumed = mbrtowc(&wc, s, len, &ps);
-        if (consumed == (size_t)-1 || consumed == (size_t)-2) {
-            // invalid/partial sequence, render a replacement char
-            wc = L'?';
-            consumed = 1; // skip one byte to make progress
-            // reset state on error
-            memset(&ps, 0, sizeof(ps));
-        } else if (consumed == 0) {
-            break; // null terminator
-        }
-        int w = wcwidth(wc);
-        if (w < 0) w = 1; // Non-printable -> width 1 fallback
+        char32_t cp;
+        int consumed = decodeUtf8(s, len, cp);
+        if (cp == 0) break; // null terminator
+        // Invalid bytes are written through as they are, one column each
+        int w = glyphWidth(cp);
         if (col + w > cols) break; // clip at right edge
 
-        // Prepare the primary cell with UTF-8 bytes
-        characterSpace cell{};
-        cell.character = '\0';
-        cell.colorForeground = fg;
-        cell.colorBackground = bg;
-        cell.utf8.assign(s, consumed);
-        drawCharacter(cell, col, y);
+        // Primary cell carries the UTF-8 bytes inline
+        drawGlyph(s, consumed, fg, bg, col, y, w);
 
         // Fill continuation cells as placeholders (no glyph printed, just colors)
         for (int i = 1; i < w; ++i) {
             if (col + i >= cols) break;
-            characterSpace cont{};
-            cont.character = '\0';
-            cont.colorForeground = fg;
-            cont.colorBackground = bg;
-            cont.utf8.clear();
-            drawCharacter(cont, col + i, y);
+            drawGlyph(nullptr, 0, fg, bg, col + i, y);
         }
         col += std::max(1, w);
         s += consumed;
-        len -= consumed;
+        len -= static_cast<size_t>(consumed);
     }
 }
 
 int TUImanager::measureColumns(const std::string& str) {
-    mbstate_t ps{};
-    const char* s = str.c_str();
-    size_t len = str.size();
-    int cols = 0;
-    while (len > 0) {
-        wchar_t wc;
-        size_t consumed = mbrtowc(&wc, s, len, &ps);
-        if (consumed == (size_t)-1 || consumed == (size_t)-2) {
-            // invalid/partial; count as 1 column and skip a byte
-            cols += 1;
-            consumed = 1;
-            memset(&ps, 0, sizeof(ps));
-        } else if (consumed == 0) {
-            break;
-        } else {
-            int w = wcwidth(wc);
-            if (w < 0) w = 1;
-            cols += std::max(1, w);
-        }
-        s += consumed;
-        len -= consumed;
-    }
-    return cols;
+    return utf8Columns(str.data(), str.size());
 }
 
 void TUImanager::drawBox(int x, int y, int width, int height, color borderFg, color borderBg, color fillBg) {
@@ -431,16 +674,10 @@ void TUImanager::drawBox(int x, int y, int width, int height, color borderFg, co
     // Middle rows
     for (int row = 1; row < height - 1; ++row) {
         drawString(ver, borderFg, borderBg, x, y + row);
-        // fill interior with spaces with fillBg
-        for (int col = 1; col < width - 1; ++col) {
-            characterSpace fillCell{};
-            fillCell.character = ' ';
-            fillCell.colorForeground = borderFg;
-            fillCell.colorBackground = fillBg;
-            drawCharacter(fillCell, x + col, y + row);
-        }
         drawString(ver, borderFg, borderBg, x + width - 1, y + row);
     }
+    // fill interior with spaces with fillBg
+    fillRect(x + 1, y + 1, width - 2, height - 2, borderFg, fillBg);
 
     // Bottom row
     drawString(bl, borderFg, borderBg, x, y + height - 1);
@@ -456,13 +693,9 @@ void TUImanager::focusContainer(container* target, int index) {
         if (auto* curElem = containerID->getFocused()) {
             curElem->notifyHover(*this, false);
         }
-        // Clear the previous container's area in the buffer so anything drawn above it (e.g., a popup)
-        // doesn't leave remnants when that top container is hidden. Use the previous container's background.
-        // We clear using its style.bg so the terminal shows the container's background when re-rendered.
+        // A container that stops being drawn (a closed modal) drops out of the composite at the end
+        // of the pass, uncovering what is below it; only its highlight changes here
         containerID->setHovered(false);
-        // compute area to clear: full container box
-    standardStyle prevStyle = containerID->getStyle();
-    clearRect(containerID->position.x, containerID->position.y, containerID->size.x, containerID->size.y, prevStyle.bg);
     }
 
     // Switch
@@ -482,6 +715,42 @@ void TUImanager::focusContainer(container* target, int index) {
     containerID->setHovered(true);
 }
 
+container::~container() {
+    if (trackedBy) trackedBy->untrackContainer(this);
+}
+
+void container::applyScreenLayout(TUImanager& tui) {
+    if (layoutCols == tui.cols && layoutRows == tui.rows) return;
+    layoutCols = tui.cols;
+    layoutRows = tui.rows;
+    const element::LayoutSpec& L = layout;
+    auto edge = [](float percent, int avail) { return static_cast<int>(percent * avail / 100.0f); };
+    point pos = position, sz = size;
+    if (L.usePercentW) {
+        sz.x = L.usePercentX ? edge(L.percentX + L.percentW, tui.cols) - edge(L.percentX, tui.cols) : edge(L.percentW, tui.cols);
+        sz.x = std::max(L.minW, sz.x);
+    }
+    if (L.usePercentH) {
+        sz.y = L.usePercentY ? edge(L.percentY + L.percentH, tui.rows) - edge(L.percentY, tui.rows) : edge(L.percentH, tui.rows);
+        sz.y = std::max(L.minH, sz.y);
+    }
+    if (L.usePercentX) {
+        pos.x = edge(L.percentX, tui.cols);
+        if (L.anchorX == element::AnchorX::Center) pos.x -= sz.x / 2;
+        else if (L.anchorX == element::AnchorX::Right) pos.x -= sz.x;
+    }
+    if (L.usePercentY) {
+        pos.y = edge(L.percentY, tui.rows);
+        if (L.anchorY == element::AnchorY::Middle) pos.y -= sz.y / 2;
+        else if (L.anchorY == element::AnchorY::Bottom) pos.y -= sz.y;
+    }
+    if (pos.x != position.x || pos.y != position.y || sz.x != size.x || sz.y != size.y) {
+        position = pos;
+        size = sz;
+        dirty = true; // children re-resolve on their own: their layout cache is keyed on our geometry
+    }
+}
+
 // container rendering moved out of header to avoid incomplete type usage
 void container::render(TUImanager& tui) {
     // If this container is the active one in the TUImanager, treat it as hovered so
@@ -490,31 +759,127 @@ void container::render(TUImanager& tui) {
     color useBg = active ? style.bgHi : style.bg;
     color useFg = active ? style.fgHi : style.fg;
 
+    if (!trackedBy) tui.trackContainer(this);
+    const auto start = std::chrono::steady_clock::now();
+    applyScreenLayout(tui);
+    double layoutUs = usSince(start);
+    // The container draws into its own surface, so whatever is stacked over it or shown in its
+    // place meanwhile leaves its cells alone. Full redraw when the surface is new or resized, when
+    // invalidated, or when the highlight changed.
+    const bool fresh = tui.beginSurface(layer, {position.x, position.y, size.x, size.y}, zIndex, true);
+    bool full = fresh || !tui.retainedMode || dirty || active != lastActive;
+    lastActive = active;
+    if (!full && !childDirty) { tui.endSurface(); tui.profileLayout(layoutUs); return; }
+
     // Set z for this container rendering
     int prevZ = tui.getCurrentZ();
     tui.setCurrentZ(zIndex);
 
-    if (renderBox) {
-        tui.drawBox(position.x, position.y, size.x, size.y, useFg, useBg, useBg);
-    } else {
-        // If not rendering the box, still clear the interior area so children render on a clean background.
-        tui.clearRect(position.x + 1, position.y + 1, std::max(0, size.x - 2), std::max(0, size.y - 2), useBg);
+    if (full || !renderDirtyElements(tui, useFg, useBg, layoutUs)) {
+        if (renderBox) {
+            tui.drawBox(position.x, position.y, size.x, size.y, useFg, useBg, useBg);
+        } else {
+            // If not rendering the box, still clear the interior area so children render on a clean background.
+            tui.clearRect(position.x + 1, position.y + 1, std::max(0, size.x - 2), std::max(0, size.y - 2), useBg);
+        }
+
+        for (element* el : elements) {
+            const auto layoutStart = std::chrono::steady_clock::now();
+            el->applyLayoutForFrame(tui);
+            layoutUs += usSince(layoutStart);
+            tui.beginTrack();
+            el->render(tui);
+            el->drawnBounds = tui.endTrack();
+            el->dirty = false;
+        }
+
+        if (renderBox && label != "") {
+            tui.drawString("{", useFg, useBg, position.x+1, position.y);
+            tui.drawString(label, useFg, useBg, position.x+2, position.y);
+            int labelCols = tui.measureColumns(label);
+            tui.drawString("}", useFg, useBg, position.x + 2 + labelCols, position.y);
+        }
+    }
+    dirty = false;
+    childDirty = false;
+
+    // Restore previous z
+    tui.setCurrentZ(prevZ);
+    tui.endSurface();
+    tui.profileLayout(layoutUs);
+    tui.profileContainer(this, usSince(start) - layoutUs);
+}
+
+// Partial redraw: clear what the dirty elements drew last time and draw them again. Elements that
+// overlap them are redrawn too, in order, so the result matches a full redraw. Returns false (having
+// drawn nothing) when an element reaches outside the interior, and false after drawing when an
+// element grew onto something that was not redrawn; the caller then repaints everything.
+bool container::renderDirtyElements(TUImanager& tui, color useFg, color useBg, double& layoutUs) {
+    const rect interior{position.x + 1, position.y + 1, size.x - 2, size.y - 2};
+    const size_t n = elements.size();
+    std::vector<char> redo(n, 0);
+    bool grew = true;
+    for (size_t i = 0; i < n; ++i) {
+        if (elements[i]->dirty) redo[i] = 1;
+    }
+    // Close over overlap: anything sharing cells with a redrawn element is redrawn as well
+    while (grew) {
+        grew = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (!redo[i]) continue;
+            for (size_t j = 0; j < n; ++j) {
+                if (!redo[j] && elements[j]->drawnBounds.overlaps(elements[i]->drawnBounds)) { redo[j] = 1; grew = true; }
+            }
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (redo[i] && !interior.contains(elements[i]->drawnBounds)) return false;
     }
 
-    for (element* el : elements) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!redo[i]) continue;
+        const rect& old = elements[i]->drawnBounds;
+        if (renderBox) tui.fillRect(old.x, old.y, old.w, old.h, useFg, useBg);
+        else tui.clearRect(old.x, old.y, old.w, old.h, useBg);
+    }
+    bool spilled = false;
+    for (size_t i = 0; i < n; ++i) {
+        if (!redo[i]) continue;
+        element* el = elements[i];
+        const auto layoutStart = std::chrono::steady_clock::now();
         el->applyLayoutForFrame(tui);
+        layoutUs += usSince(layoutStart);
+        tui.beginTrack();
         el->render(tui);
+        rect now = tui.endTrack();
+        if (!interior.contains(now)) spilled = true;
+        for (size_t j = 0; j < n && !spilled; ++j) {
+            if (!redo[j] && elements[j]->drawnBounds.overlaps(now)) spilled = true;
+        }
+        el->drawnBounds = now;
+        el->dirty = false;
     }
+    return !spilled;
+}
+
+void TUImanager::trackContainer(container* c) {
+    containers.push_back(c);
+    c->trackedBy = this;
+}
 
-    if (renderBox && label != "") {
-        tui.drawString("{", useFg, useBg, position.x+1, position.y);
-        tui.drawString(label, useFg, useBg, position.x+2, position.y);
-        int labelCols = tui.measureColumns(label);
-        tui.drawString("}", useFg, useBg, position.x + 2 + labelCols, position.y);
+void TUImanager::untrackContainer(container* c) {
+    containers.erase(std::remove(containers.begin(), containers.end(), c), containers.end());
+    c->trackedBy = nullptr;
+}
+
+void TUImanager::invalidateRect(const rect& r) {
+    for (container* c : containers) {
+        if (r.overlaps({c->position.x, c->position.y, c->size.x, c->size.y})) c->invalidate();
     }
+}
 
-    // Restore previous z
-    tui.setCurrentZ(prevZ);
+void TUImanager::invalidateAllContainers() {
+    for (container* c : containers) c->invalidate();
 }
 
 // Implementation of container::navigate moved from header to here.
@@ -592,25 +957,26 @@ void TUImanager::markDirty(int x, int y, int width, int height) {
     for (int dy = 0; dy < height; ++dy) {
         int yy = y + dy;
         if (yy < 0 || yy >= rows) continue;
+        const size_t rowBase = static_cast<size_t>(yy) * cols;
         for (int dx = 0; dx < width; ++dx) {
             int xx = x + dx;
             if (xx < 0 || xx >= cols) continue;
-            if (!dirty[yy][xx]) {
-                dirty[yy][xx] = 1;
-                ++dirtyCount;
-            }
-            // Reset the cell to background so it gets redrawn
-            screenBuffer[yy][xx].z = -1;
+            // Reset the cell to background z so it gets redrawn (z is not part of the row hash)
+            baseLayer[rowBase + xx].z = -1;
         }
     }
+    damageRect({x, y, width, height});
+    invalidateRect({x, y, width, height});
+}
+
+void TUImanager::setColorDepth(colorDepth depth) {
+    if (encoder.opts.depth == depth) return;
+    encoder.opts.depth = depth;
+    invalidateFront();
 }
 
 void TUImanager::markAllDirty() {
-    dirtyCount = static_cast<size_t>(rows) * static_cast<size_t>(cols);
-    for (int y = 0; y < rows; ++y) {
-        for (int x = 0; x < cols; ++x) {
-            dirty[y][x] = 1;
-            screenBuffer[y][x].z = -1;
-        }
-    }
+    for (cell& c : baseLayer) c.z = -1;
+    invalidateFront();
+    invalidateAllContainers();
 }
\ No newline at end of file
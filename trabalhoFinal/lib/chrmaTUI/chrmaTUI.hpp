@@ -7,15 +7,30 @@ class container;   // Forward declaration for parent linkage in element
 #include <termios.h>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <functional>
 #include <string>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <cstring>
+#include <cstdio>
 #include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
 #include <sys/ioctl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
 #include <errno.h>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
 #include <cmath>
 #include <locale.h>
 
@@ -25,6 +40,31 @@ struct point{
     int y;
 };
 
+// Screen rectangle in cells; w or h <= 0 means empty
+struct rect{
+    int x = 0, y = 0, w = 0, h = 0;
+    inline bool empty() const { return w <= 0 || h <= 0; }
+    inline bool operator==(const rect& o) const { return x == o.x && y == o.y && w == o.w && h == o.h; }
+    inline bool overlaps(const rect& o) const {
+        return !empty() && !o.empty() && x < o.x + o.w && o.x < x + w && y < o.y + o.h && o.y < y + h;
+    }
+    inline bool contains(const rect& o) const {
+        return o.empty() || (o.x >= x && o.y >= y && o.x + o.w <= x + w && o.y + o.h <= y + h);
+    }
+    inline rect united(const rect& o) const {
+        if (empty()) return o;
+        if (o.empty()) return *this;
+        int x0 = std::min(x, o.x), y0 = std::min(y, o.y);
+        return {x0, y0, std::max(x + w, o.x + o.w) - x0, std::max(y + h, o.y + o.h) - y0};
+    }
+    inline rect intersected(const rect& o) const {
+        int x0 = std::max(x, o.x), y0 = std::max(y, o.y);
+        int x1 = std::min(x + w, o.x + o.w), y1 = std::min(y + h, o.y + o.h);
+        if (x1 <= x0 || y1 <= y0) return {};
+        return {x0, y0, x1 - x0, y1 - y0};
+    }
+};
+
 typedef struct color{
     uint8_t r;
     uint8_t g;
@@ -50,6 +90,98 @@ typedef struct characterSpace{
     std::string utf8;
 } characterSpace;
 
+// Framebuffer cell. The glyph is stored inline (no heap) and the colors are a styleTable id, so
+// a whole cell is 10 bytes and the framebuffer is one contiguous row-major array.
+// glyphLen == 0 marks a placeholder (continuation of a wide glyph): nothing is printed for it.
+typedef struct cell{
+    char glyph[4];     // UTF-8 bytes of a single code point, NUL padded
+    uint16_t style;    // interned fg/bg pair, see styleTable
+    int16_t z;         // z-order for layering (higher draws over lower)
+    uint8_t glyphLen;  // number of valid bytes in glyph (0..4)
+    uint8_t flags;     // cellWide when the glyph covers two columns; cellEmpty
+} cell;
+static const uint8_t cellWide = 0x01;
+static const uint8_t cellEmpty = 0x02; // a surface cell nothing has drawn to: the layers below show through
+static_assert(sizeof(cell) == 10, "cell must stay 10 bytes");
+
+// Cells compare equal on screen when glyph and style match; z and glyphLen are bookkeeping
+// (glyph is NUL padded, so its bytes already determine the length).
+inline bool cellVisiblyEqual(const cell& a, const cell& b) { return std::memcmp(&a, &b, 6) == 0; }
+
+// Per-cell contribution to a row hash. Row hashes are the XOR of these, so a single cell
+// write updates its row hash in O(1) and two rows can be compared without scanning.
+inline uint64_t cellHash(const cell& c, int x) {
+    uint32_t glyph;
+    std::memcpy(&glyph, c.glyph, 4);
+    uint64_t h = ((uint64_t(c.style) << 32) | glyph) ^ (uint64_t(x) << 48) ^ (uint64_t(x) * 0x9E3779B97F4A7C15ull);
+    h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27; h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return h;
+}
+
+inline uint32_t packColor(color c) { return (uint32_t(c.r) << 16) | (uint32_t(c.g) << 8) | uint32_t(c.b); }
+inline color unpackColor(uint32_t v) { return {uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v), 255}; }
+
+// Never handed out by styleTable: a cell with it differs from every real cell
+static const uint16_t styleUnknown = 0xFFFF;
+
+// Interns every packed (fg, bg) pair drawn to a 16-bit id. Cells store the id, so "same colors"
+// is one integer compare and the encoder can keep each id's SGR bytes. Id 0 is black on black,
+// which is what a zeroed cell means. Ids are only reused after TUImanager compacts the table.
+class styleTable {
+    public:
+    styleTable();
+    // Id for the pair, or styleUnknown when all ids are taken (see nearest)
+    inline uint16_t intern(uint32_t fg, uint32_t bg) {
+        const uint64_t key = (uint64_t(fg) << 24) | bg;
+        if (key == lastKey) return lastId; // runs of one color are the common case
+        return internSlow(key);
+    }
+    inline uint32_t fg(uint16_t id) const { return entries[id].fg; }
+    inline uint32_t bg(uint16_t id) const { return entries[id].bg; }
+    inline size_t size() const { return entries.size(); }
+    // Keep the ids whose live[] entry is set (0 always is), renumbered densely in the same order;
+    // remap[old] is the new id of each kept one. False, leaving the table alone, if all are live.
+    bool compact(const std::vector<uint8_t>& live, std::vector<uint16_t>& remap);
+    // Existing id whose colors are closest to the pair, for when it cannot be interned. Looked up
+    // once per coarse color bucket until the next compact.
+    uint16_t nearest(uint32_t fg, uint32_t bg);
+    private:
+    struct entry { uint32_t fg, bg; };
+    std::vector<entry> entries;   // by id
+    std::vector<uint16_t> slots;  // open addressing on the key, styleUnknown when free
+    std::vector<uint16_t> nearCache; // nearest() by bucket, styleUnknown until looked up
+    uint64_t lastKey = 0;
+    uint16_t lastId = 0;
+    uint16_t internSlow(uint64_t key);
+    void rehash(size_t slotCount);
+};
+
+// UTF-8 and display width, independent of the C locale.
+// Decode the code point at s (len >= 1 bytes available) and return the bytes it used. Invalid,
+// overlong or truncated sequences give U+FFFD and consume one byte.
+int decodeUtf8(const char* s, size_t len, char32_t& cp);
+// Terminal columns of a code point: 0 for combining/format characters, 2 for East Asian
+// Wide/Fullwidth, 1 otherwise (controls included)
+int glyphWidth(char32_t cp);
+// Columns of a UTF-8 string, counting every code point as at least one column like drawString does.
+// Pure ASCII is counted 16 bytes at a time.
+int utf8Columns(const char* s, size_t len);
+
+// (dst * (255 - a) + src * a) / 255 per channel of a packed color, truncated. The division is the
+// exact shift form for t <= 65025, so the scalar and SIMD paths agree bit for bit.
+inline uint32_t blendPacked(uint32_t dst, uint32_t src, uint8_t a) {
+    uint32_t out = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        uint32_t t = ((dst >> shift) & 0xFF) * (255u - a) + ((src >> shift) & 0xFF) * a;
+        out |= ((t + 1 + (t >> 8)) >> 8) << shift;
+    }
+    return out;
+}
+// Blend n packed colors of dst toward src[i] in place. AVX2/SSE2 when the CPU has them.
+void blendPackedRow(uint32_t* dst, const uint32_t* src, size_t n, uint8_t a);
+
 enum userState{
     NAVIGATING,
     INTERACTING,
@@ -102,30 +234,39 @@ class element{
         virtual void render(TUImanager& tui) = 0;  // Pure virtual: must implement
         virtual void onHover(bool isHovered) = 0;
     virtual void onInteract(pressedKey /*key*/, char /*c*/, uint8_t& /*userState*/, TUImanager& /*tui*/) {}
+        // count presses of the same arrow key in a row. The default delivers them one at a time
+        // while userState stays the same; lists override it to move in one step.
+        virtual void onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui);
+        // A bracketed paste. The default types it in byte by byte like onInteract(UNKNOWN, c);
+        // text inputs override it to insert the whole payload at once.
+        virtual void onPaste(const char* text, size_t len, uint8_t& userState, TUImanager& tui);
         virtual void update() {}
         virtual bool capturesInput() { return false; }
         virtual bool canBeFocused() const { return true; }
 
-    // Compute and apply percent/anchor-based layout for this frame
+    // Compute and apply percent/anchor-based layout for this frame. The result is cached and
+    // reused until the parent's geometry or the terminal size changes, or invalidateLayout().
     void applyLayoutForFrame(TUImanager& tui);
+    // Drop the cached layout; the layout setters call this
+    inline void invalidateLayout() { layoutValid = false; invalidate(); }
 
     // Unified styling setter for all elements
-    inline void setStyle(const standardStyle& s) { style = s; hasCustomStyle = true; }
+    inline void setStyle(const standardStyle& s) { style = s; hasCustomStyle = true; invalidate(); }
     inline bool hasStyle() const { return hasCustomStyle; }
-    inline void setParent(container* p) { parent = p; }
+    inline void setParent(container* p) { parent = p; layoutValid = false; }
     inline container* getParent() const { return parent; }
 
         // Layout setters
-        inline void setPercentPosition(float px, float py) { layout.usePercentX = true; layout.usePercentY = true; layout.percentX = px; layout.percentY = py; }
-        inline void setPercentX(float px) { layout.usePercentX = true; layout.percentX = px; }
-        inline void setPercentY(float py) { layout.usePercentY = true; layout.percentY = py; }
-        inline void setOffsets(int ox, int oy) { layout.offsetX = ox; layout.offsetY = oy; }
-        inline void setPercentSize(float pw, float ph) { layout.usePercentW = true; layout.usePercentH = true; layout.percentW = pw; layout.percentH = ph; }
-        inline void setPercentW(float pw) { layout.usePercentW = true; layout.percentW = pw; }
-        inline void setPercentH(float ph) { layout.usePercentH = true; layout.percentH = ph; }
-        inline void setMinSize(int w, int h) { layout.minW = w; layout.minH = h; }
-        inline void setAnchors(AnchorX ax, AnchorY ay) { layout.anchorX = ax; layout.anchorY = ay; }
-        inline void setRelativeToInterior(bool v) { layout.relativeToInterior = v; }
+        inline void setPercentPosition(float px, float py) { layout.usePercentX = true; layout.usePercentY = true; layout.percentX = px; layout.percentY = py; invalidateLayout(); }
+        inline void setPercentX(float px) { layout.usePercentX = true; layout.percentX = px; invalidateLayout(); }
+        inline void setPercentY(float py) { layout.usePercentY = true; layout.percentY = py; invalidateLayout(); }
+        inline void setOffsets(int ox, int oy) { layout.offsetX = ox; layout.offsetY = oy; invalidateLayout(); }
+        inline void setPercentSize(float pw, float ph) { layout.usePercentW = true; layout.usePercentH = true; layout.percentW = pw; layout.percentH = ph; invalidateLayout(); }
+        inline void setPercentW(float pw) { layout.usePercentW = true; layout.percentW = pw; invalidateLayout(); }
+        inline void setPercentH(float ph) { layout.usePercentH = true; layout.percentH = ph; invalidateLayout(); }
+        inline void setMinSize(int w, int h) { layout.minW = w; layout.minH = h; invalidateLayout(); }
+        inline void setAnchors(AnchorX ax, AnchorY ay) { layout.anchorX = ax; layout.anchorY = ay; invalidateLayout(); }
+        inline void setRelativeToInterior(bool v) { layout.relativeToInterior = v; invalidateLayout(); }
         inline const LayoutSpec& getLayout() const { return layout; }
 
         // User-provided callbacks
@@ -147,8 +288,22 @@ class element{
         void notifyHover(TUImanager& tui, bool hovered) {
             isHovered = hovered;
             onHover(hovered);
+            invalidate();
             if (onHoverHandler) onHoverHandler(*this, tui, hovered);
         }
+        // Deliver input and schedule a redraw; what TUImanager::pollInput uses instead of onInteract
+        void notifyInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) {
+            onInteract(key, c, userState, tui);
+            invalidate();
+        }
+        void notifyInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) {
+            onInteractRepeat(key, count, userState, tui);
+            invalidate();
+        }
+        void notifyPaste(const char* text, size_t len, uint8_t& userState, TUImanager& tui) {
+            onPaste(text, len, userState, tui);
+            invalidate();
+        }
         void notifyClick(TUImanager& tui) {
             if (onClickHandler) onClickHandler(*this, tui);
         }
@@ -157,6 +312,12 @@ class element{
         }
 
         point renderPos; // Calculated absolute position for rendering.
+
+        // Retained mode: containers only re-render elements that were invalidated. Hover, input
+        // delivered through notifyInteract and the setters call this; code that writes public
+        // fields directly has to call it as well.
+        void invalidate();
+        inline bool isDirty() const { return dirty; }
     
     protected:
         point position, size;
@@ -165,6 +326,39 @@ class element{
     bool hasCustomStyle = false; // whether user explicitly set a style
     LayoutSpec layout; // generic layout for all elements
         bool isHovered;
+        friend class container;
+        bool dirty = true;
+        rect drawnBounds; // cells touched by the last render(), cleared before a partial redraw
+        // Layout cache: what applyLayoutForFrame resolved renderPos/size against
+        bool layoutValid = false;
+        rect layoutParent;
+        int layoutCols = 0, layoutRows = 0;
+};
+
+// Offscreen layer. A container, an open dropdown list, the notification stack... draws into its
+// own surface between TUImanager::beginSurface and endSurface, and render() composites the
+// visible surfaces over the base layer by z, only where something changed. Hiding one shows the
+// cached layers below it again without redrawing them.
+class surface {
+    public:
+    surface() = default;
+    surface(const surface&) = delete;
+    surface& operator=(const surface&) = delete;
+    ~surface();
+    inline const rect& area() const { return bounds; }
+    inline bool visible() const { return shown; }
+
+    private:
+    friend class TUImanager;
+    TUImanager* owner = nullptr;
+    rect bounds;
+    int z = 0;
+    bool shown = false;
+    bool autoHide = false;        // hidden at the end of a pass it was not drawn in
+    unsigned long lastPass = 0;   // TUImanager::framePass it was last drawn in
+    surface* parent = nullptr;    // only shown while the parent is
+    std::vector<cell> cells;      // bounds.w * bounds.h, row-major
+    inline cell* row(int y) { return &cells[static_cast<size_t>(y - bounds.y) * bounds.w] - bounds.x; }
 };
 
 class container {
@@ -174,11 +368,23 @@ class container {
         std::string label = "";
         container(point pos, point sz, standardStyle st, std::string lbl)
             : position(pos), size(sz), label(lbl), style(st), defaultElementStyle(st) {}
+        ~container();
+        container(const container&) = delete;
+        container& operator=(const container&) = delete;
 
     // Stacking order for this container (higher draws above lower)
     inline void setZIndex(int z) { zIndex = z; }
     inline int getZIndex() const { return zIndex; }
 
+    // Screen-relative layout, resolved against the terminal size by render() whenever it changes.
+    // Percent edges are rounded individually, so containers that share an edge (0-30% and 30-100%)
+    // tile the screen without gaps. Axes left unset keep the constructor's position/size.
+    inline void setPercentPosition(float px, float py) { layout.usePercentX = true; layout.usePercentY = true; layout.percentX = px; layout.percentY = py; layoutCols = -1; }
+    inline void setPercentSize(float pw, float ph) { layout.usePercentW = true; layout.usePercentH = true; layout.percentW = pw; layout.percentH = ph; layoutCols = -1; }
+    inline void setAnchors(element::AnchorX ax, element::AnchorY ay) { layout.anchorX = ax; layout.anchorY = ay; layoutCols = -1; }
+    // Resolve the screen layout if the terminal size changed since the last call
+    void applyScreenLayout(TUImanager& tui);
+
     TUImanager* tui = nullptr; // set by owner so we can deliver it to callbacks
     
         std::vector<element*> elements;
@@ -194,8 +400,20 @@ class container {
                 e->setStyle(defaultElementStyle);
             }
             elements.push_back(e);
+            dirty = true;
         }
-        void removeElement(size_t index) { elements.erase(elements.begin() + index); }
+        void removeElement(size_t index) { elements.erase(elements.begin() + index); dirty = true; }
+
+        // Retained mode: the next render() redraws box, label and every element
+        inline void invalidate() { dirty = true; }
+        // Re-resolve every element's layout on the next render()
+        inline void invalidateLayout() {
+            for (element* e : elements) e->layoutValid = false;
+            dirty = true;
+        }
+        // Called by element::invalidate(): the next render() redraws just the dirty elements
+        inline void childInvalidated() { childDirty = true; }
+        inline bool needsRender() const { return dirty || childDirty; }
 
         // Navigate vertically within this container (implemented in .cpp)
         void navigate(pressedKey dir);
@@ -220,7 +438,7 @@ class container {
     // Set container visibility: when hidden, the container will not draw its box or label
     inline void isHiddenContainer(bool hidden) { renderBox = !hidden; }
 
-    void setStyle(standardStyle style) { this->style = style; }
+    void setStyle(standardStyle style) { this->style = style; dirty = true; }
     void setDefaultElementStyle(const standardStyle& s) { defaultElementStyle = s; }
     void setInheritStyle(bool enabled) { inheritStyle = enabled; }
     // Expose style for read-only access (used by TUImanager for clearing/redrawing)
@@ -248,6 +466,19 @@ class container {
 
         bool isHovered = false;
 
+        element::LayoutSpec layout; // screen-relative geometry; unused axes keep position/size
+        int layoutCols = -1, layoutRows = -1; // terminal size the layout was resolved for
+
+        // Retained-mode state
+        bool dirty = true;
+        bool childDirty = false;
+        bool lastActive = false;
+        surface layer;                     // what it draws; shown while it renders every pass
+        TUImanager* trackedBy = nullptr;   // registered for TUImanager::invalidateRect
+        friend class TUImanager;
+        // Redraw only the dirty elements; false when that cannot be done without a full redraw
+        bool renderDirtyElements(TUImanager& tui, color useFg, color useBg, double& layoutUs);
+
         void updateFocus() {
                 for (size_t i = 0; i < elements.size(); ++i) {
                 bool shouldHover = (static_cast<int>(i) == focusedIndex) && elements[i]->canBeFocused();
@@ -260,9 +491,353 @@ class container {
         }
     };
 
+// Byte buffer reused for every frame. It only grows, so once it has seen the largest frame
+// encoding performs no allocations at all.
+class outputArena {
+    public:
+    inline void clear() { len = 0; }
+    inline void reserve(size_t n) { if (n > buf.size()) buf.resize(n); }
+    inline void put(const char* s, size_t n) {
+        if (len + n > buf.size()) grow(n);
+        std::memcpy(buf.data() + len, s, n);
+        len += n;
+    }
+    inline void put(char c) {
+        if (len + 1 > buf.size()) grow(1);
+        buf[len++] = c;
+    }
+    // Append an unsigned decimal number (0..255 comes straight from a lookup table)
+    void putUInt(unsigned v);
+    inline const char* data() const { return buf.data(); }
+    inline size_t size() const { return len; }
+    private:
+    std::vector<char> buf;
+    size_t len = 0;
+    void grow(size_t n);
+};
+
+// How much of REP (CSI n b, repeat the preceding graphic character) a terminal implements
+enum repeatSupport : uint8_t {
+    repeatNone,
+    repeatAscii, // tmux only repeats single-byte characters and drops the rest silently
+    repeatAny
+};
+
+// Color depth the encoder quantizes to. Indexed modes map 0xRRGGBB through a 15-bit lookup table.
+enum colorDepth : uint8_t {
+    depthTrueColor, // 38;2;r;g;b
+    depth256,       // 38;5;n over the 6x6x6 cube and gray ramp (16..255)
+    depth16         // 30-37/90-97, xterm's default palette
+};
+
+// How the encoder may shift screen content instead of repainting it
+enum scrollSupport : uint8_t {
+    scrollNone,
+    scrollRows,   // DECSTBM + SU/SD on full-width row bands (every VT100 descendant)
+    scrollMargins // plus DECLRMM/DECSLRM left/right margins, so a column range scrolls alone (xterm)
+};
+
+// Turns the difference between two frames into escape sequences inside a single arena,
+// which is then handed to the terminal with one write() per frame. The encoder tracks the
+// terminal cursor and SGR state so it can pick the cheapest way to get each byte on screen.
+class frameEncoder {
+    public:
+    struct options {
+        bool relativeMoves = true; // cheapest of CUP, CUU/CUD/CUF/CUB, CR/LF or reprinting unchanged cells
+        bool eraseRuns = true;     // clear runs of blank cells with ECH/EL; spaces never switch fg
+        bool carryColors = true;   // keep SGR state across rows and spans instead of re-sending it
+        repeatSupport repeatRuns = repeatNone; // REP for runs of identical cells; set from detectRepeatSupport()
+        colorDepth depth = depthTrueColor;      // set from detectColorDepth()
+        bool syncUpdates = false;  // bracket each frame in DEC mode 2026 so it is shown atomically
+        scrollSupport scrolls = scrollNone;     // set from detectScrollSupport()
+    };
+    options opts;
+    outputArena out;
+    const styleTable* styles = nullptr; // what the cells' style ids mean; set by TUImanager
+
+    inline void setScreenSize(int c, int r) { cols = c; rows = r; }
+    void beginFrame();                        // clear arena, forget cursor/SGR state, begin sync, disable autowrap
+    void beginBand();                         // beginFrame without the prologue, for rows spliced into a frame later
+    void endFrame();                          // reset attributes, restore autowrap, end sync
+    // Emit every cell of row y where back differs from front. Returns the number of cells written.
+    size_t encodeRow(const cell* back, const cell* front, int y);
+    void moveTo(int x, int y);                // 0-based, cheapest sequence from the tracked cursor
+    void setStyle(uint16_t style);            // emits SGR only for the channels that changed
+    void setBackground(uint16_t style);       // just the background of style
+    inline void forgetColors() { curFg = curBg = 0xFFFFFFFFu; curStyle = styleUnknown; }
+    // The style ids were renumbered (TUImanager::compactStyles): drop the cached SGR bytes
+    inline void forgetStyles() { sgrCache.clear(); forgetColors(); }
+    inline void forgetCursor() { curX = curY = -1; }
+    // Tracked cursor and SGR state: with the cells, everything encodeRow's output depends on
+    struct state {
+        int x, y;
+        uint32_t fg, bg;
+        uint16_t style;
+        inline bool operator==(const state& o) const {
+            return x == o.x && y == o.y && fg == o.fg && bg == o.bg && style == o.style;
+        }
+    };
+    inline state saveState() const { return {curX, curY, curFg, curBg, curStyle}; }
+    inline void restoreState(const state& s) { curX = s.x; curY = s.y; curFg = s.fg; curBg = s.bg; curStyle = s.style; }
+    void glyph(const cell& c);                // print and advance the tracked cursor
+    // Shift the cells of r up by dy rows (down when negative) on the terminal; the rows exposed at
+    // the other end are left in the current background. Uses left/right margins unless r spans the
+    // whole width. Leaves the cursor untracked.
+    void scrollRegion(const rect& r, int dy);
+    // What the terminal is told for rgb at the current depth: rgb itself, or 0x1000000 | palette index,
+    // so two colors that quantize alike do not re-send SGR
+    uint32_t colorKey(uint32_t rgb) const;
+    // Write the whole arena to fd, retrying on partial writes/EINTR. Returns false on error.
+    bool flush(int fd);
+    private:
+    int cols = 0, rows = 0;
+    int curX = -1, curY = -1;     // tracked cursor, -1 when unknown
+    uint32_t curFg = 0xFFFFFFFFu; // impossible value forces the first SGR
+    uint32_t curBg = 0xFFFFFFFFu;
+    uint16_t curStyle = styleUnknown; // a style whose colors are exactly curFg/curBg
+    // Per style id: the colorKeys and the exact SGR sequences that select them at sgrDepth
+    struct sgrEntry {
+        uint32_t fgKey, bgKey;
+        uint8_t fgLen, bgLen;     // fgLen 0: not built yet
+        char fgSgr[19], bgSgr[19];
+    };
+    std::vector<sgrEntry> sgrCache;
+    colorDepth sgrDepth = depthTrueColor;
+    const sgrEntry& sgr(uint16_t style); // valid until the next call
+    int moveCost(int x, int y) const;
+    void emitCSI(unsigned n, char final); // CSI n final, omitting n when it is 1
+    uint8_t formatColor(uint32_t key, bool background, char* dst) const; // the SGR for key, returns its length
+};
+
+// One decoded keypress, or a whole bracketed paste
+struct inputEvent {
+    pressedKey key = UNKNOWN;
+    char c = 0;     // the byte for plain keys, 0 for escape sequences
+    int count = 1;  // > 1 when a run of the same arrow key was coalesced
+    bool paste = false;
+    size_t pasteOffset = 0, pasteLen = 0; // paste text: inputDecoder::pasted.substr(offset, len)
+};
+
+// Turns raw terminal input into key events. Everything readable is drained into a ring buffer
+// with as few read() calls as the ring allows, and a state machine (ground, ESC, CSI, SS3,
+// paste) walks the bytes; a sequence split across reads resumes where it stopped.
+class inputDecoder {
+    public:
+    std::vector<inputEvent> events; // current batch, appended to by drain()
+    std::string pasted;             // text of the paste events in the batch
+    inline void beginBatch() { events.clear(); pasted.clear(); }
+    // Read and decode everything available on fd. Returns false on a read error.
+    bool drain(int fd);
+    // A lone ESC or a partial CSI/SS3 sequence is waiting for more bytes
+    inline bool midSequence() const { return state == stEsc || state == stCsi || state == stSs3; }
+    // Nothing more arrived: a pending ESC is the Escape key, a partial sequence is dropped
+    void flushPending();
+    private:
+    enum parseState : uint8_t { stGround, stEsc, stCsi, stSs3, stPaste };
+    static constexpr size_t kRingSize = 4096; // power of two
+    char ring[kRingSize];
+    size_t head = 0, tail = 0; // free-running; head - tail bytes are buffered
+    parseState state = stGround;
+    char params[16];   // CSI parameter and intermediate bytes
+    int paramLen = 0;
+    int pasteMatch = 0; // bytes of the ESC[201~ terminator matched so far
+    std::string pasteBuf; // paste in progress, may span batches
+    void decode();      // consume every buffered byte
+    void step(char b);
+    void emit(pressedKey key, char c);
+    void dispatchCsi(char final);
+};
+
+// Where a TUImanager gets its size, input and output. ttyBackend drives the real terminal;
+// headlessBackend is an in-memory one for tests and benchmarks.
+class terminalBackend {
+    public:
+    virtual ~terminalBackend() = default;
+    // Take over the terminal (raw mode, hidden cursor...) and adjust opts to what it supports
+    virtual void open(frameEncoder::options& /*opts*/) {}
+    virtual void close() {}
+    virtual void getSize(int& rows, int& cols) = 0;
+    virtual int inputFd() = 0;                  // non-blocking; the event loop waits on it
+    virtual int resizeFd() { return -1; }       // readable when the size may have changed
+    virtual bool takeResize() { return false; } // consume that notification; true if there was one
+    // Like write(2): may take less than n, or fail with EAGAIN while the sink is full
+    virtual ssize_t write(const char* p, size_t n) = 0;
+    virtual int outputFd() { return -1; }       // polled for POLLOUT after EAGAIN; -1 if never full
+};
+
+// The process's controlling terminal: stdin/stdout in raw mode, SIGWINCH through a signalfd,
+// capabilities guessed from the environment (detectRepeatSupport and friends)
+class ttyBackend : public terminalBackend {
+    public:
+    int outFd = STDOUT_FILENO; // made non-blocking by open()
+    void open(frameEncoder::options& opts) override;
+    void close() override;
+    void getSize(int& rows, int& cols) override;
+    int inputFd() override { return STDIN_FILENO; }
+    int resizeFd() override;
+    bool takeResize() override;
+    ssize_t write(const char* p, size_t n) override { return ::write(outFd, p, n); }
+    int outputFd() override { return outFd; }
+};
+
+// Cell of headlessBackend's decoded screen. Colors are the encoder's color keys (see
+// frameEncoder::colorKey); kDefaultColor until an SGR sets them.
+struct vtCell {
+    char glyph[4];
+    uint8_t glyphLen;
+    uint32_t fg, bg;
+};
+
+// In-memory terminal: a fixed-size screen, input scripted through a pipe (so the event loop and
+// the input decoder see it like a tty) and an output sink that keeps the bytes and/or decodes them
+// into a grid of vtCells, understanding everything frameEncoder emits.
+class headlessBackend : public terminalBackend {
+    public:
+    static constexpr uint32_t kDefaultColor = 0xFFFFFFFFu;
+    bool captureBytes = false; // keep everything written in output
+    bool decodeScreen = true;  // interpret the output into screen()
+    std::string output;
+    size_t bytesWritten = 0;
+    size_t writeCalls = 0;
+
+    headlessBackend(int rows = 24, int cols = 80);
+    ~headlessBackend() override;
+    void getSize(int& r, int& c) override { r = rows; c = cols; }
+    int inputFd() override { return inPipe[0]; }
+    int resizeFd() override { return resizePipe[0]; }
+    bool takeResize() override;
+    ssize_t write(const char* p, size_t n) override;
+
+    // Queue bytes as if they were typed. False if the pipe had no room for all of them.
+    bool type(const std::string& bytes);
+    // Change the size like a SIGWINCH would; TUImanager::waitEvents picks it up
+    void setSize(int newRows, int newCols);
+    inline const vtCell& at(int x, int y) const { return screen[static_cast<size_t>(y) * cols + x]; }
+    inline int screenRows() const { return rows; }
+    inline int screenCols() const { return cols; }
+    // Cells where the decoded screen disagrees with tui's back buffer (glyph, and colors through
+    // tui's encoder depth; only the background of blanks, whose fg the encoder is free to skip)
+    size_t mismatches(const TUImanager& tui) const;
+
+    private:
+    int rows, cols;
+    int inPipe[2] = {-1, -1};
+    int resizePipe[2] = {-1, -1};
+    std::vector<vtCell> screen;
+    // VT state
+    int curX = 0, curY = 0;
+    uint32_t fg = kDefaultColor, bg = kDefaultColor;
+    int top = 0, bottom = 0, left = 0, right = 0; // scroll region, inclusive
+    bool marginsMode = false, autowrap = true;
+    vtCell lastGlyph{};
+    enum vtState : uint8_t { vtGround, vtEsc, vtCsi };
+    vtState state = vtGround;
+    std::string params;
+    char utf8[4];
+    int utf8Len = 0, utf8Need = 0;
+    void feed(char b);
+    void csi(char final);
+    void print(const char* g, int len);
+    void eraseCells(int y, int x0, int x1); // [x0, x1) in the current background
+    void scroll(int n);                      // region up by n (down when negative)
+};
+
+// Terminal output backpressure counters
+struct outputStats {
+    size_t queuedBytes = 0;    // bytes of the last frame the terminal has not taken yet
+    size_t maxQueuedBytes = 0;
+    size_t partialWrites = 0;  // write() calls that took only part of what was offered
+    size_t stalls = 0;         // times the terminal stopped taking output mid-frame
+    size_t framesSkipped = 0;  // frames not sent because the previous one was still queued
+                               // (with the writer thread: dropped as superseded)
+};
+
+// Hands encoded frames to a thread that writes them to the terminal, so a slow terminal or SSH
+// link never blocks the UI thread. Lock-free triple buffer: the UI thread encodes into one arena,
+// the writer drains another and the third holds the newest finished frame until it is taken.
+class frameWriter {
+    public:
+    ~frameWriter() { stop(); }
+    void start(terminalBackend* term);
+    void stop(); // writes a frame still pending, then joins the thread
+    inline bool running() const { return thread.joinable(); }
+    // Swap the frame encoded in out into the pending slot and wake the writer; out gets a free arena
+    void publish(outputArena& out);
+    // Withdraw the pending frame if the writer has not taken it yet. True when one was withdrawn.
+    bool retract();
+    // Add the writer's queue and write counters to stats
+    void addStats(outputStats& stats) const;
+    private:
+    static constexpr uint8_t kFresh = 4; // flag in middle: it holds a frame not taken yet
+    outputArena slots[3];
+    uint8_t uiSlot = 0, writerSlot = 1;
+    std::atomic<uint8_t> middle{2};
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> queuedBytes{0}, maxQueuedBytes{0}, partialWrites{0}, stalls{0};
+    terminalBackend* term = nullptr;
+    int wakeFd = -1; // eventfd the writer blocks on
+    std::thread thread;
+    void run();
+    void writeFrame(const outputArena& frame); // blocking, but counts partial writes and stalls
+};
+
+// A few threads that run batches of independent jobs for render() (TUImanager::setParallelEncode).
+// The calling thread takes jobs too and returns once the whole batch is done.
+class bandPool {
+    public:
+    ~bandPool() { stop(); }
+    void start(int workers);
+    void stop();
+    inline int workers() const { return count; }
+    // Run job(0) .. job(n - 1) spread over the workers and the calling thread
+    void run(int n, const std::function<void(int)>& job);
+    private:
+    std::vector<std::thread> threads;
+    int count = 0;
+    std::mutex lock;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    int jobs = 0;
+    std::atomic<int> next{0}; // next job to take
+    unsigned batch = 0;       // bumped by run(); each worker joins every batch once
+    int finished = 0;         // workers through the current batch
+    bool stopping = false;
+    void loop(unsigned seen); // seen: the last batch before this worker started
+    void work();
+};
+
+// write() all of n bytes, retrying on partial writes and EINTR. Returns false on error.
+bool writeAll(int fd, const char* p, size_t n);
+
+// Microseconds elapsed since t, for the frame profile
+inline double usSince(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count();
+}
+
 void enableRawMode();
 void disableRawMode();
+// O_NONBLOCK on stdout (and whatever shares its open file, usually the tty stdin is on too), so
+// render() never stalls on a full pty; the original flags come back at exit or on restore
+void enableNonBlockingOutput();
+void restoreBlockingOutput();
 void getTerminalSize(int& rows, int& cols);
+// SIGWINCH handling: the signal is blocked and read from a signalfd, so the event loop wakes up
+// on it and TUImanager::checkResize does the work outside any signal handler. Threads created
+// afterwards inherit the blocked mask.
+void installResizeHandler();
+void removeResizeHandler();
+bool takeResizeSignal();
+int resizeSignalFd();
+// Guess REP support from $TERM. CHRMATUI_REP=none|ascii|any overrides it.
+repeatSupport detectRepeatSupport();
+// Truecolor unless $TERM names a 16/8-color terminal. CHRMATUI_COLORS=16|256|truecolor overrides it.
+colorDepth detectColorDepth();
+// Synchronized output (mode 2026) everywhere but the linux console; terminals without it ignore the
+// DECSET. CHRMATUI_SYNC=0/1 overrides it.
+bool detectSyncSupport();
+// Left/right margins only for real xterm ($XTERM_VERSION): most terminals that call themselves
+// xterm do not implement DECLRMM. CHRMATUI_SCROLL=none|rows|margins overrides it.
+scrollSupport detectScrollSupport();
 pressedKey mapCharToKey(char c);
 
 class TUImanager{
@@ -273,54 +848,171 @@ class TUImanager{
     element* elementID;
     container* containerID;
     int rows, cols;
-    std::vector<std::vector<characterSpace>> screenBuffer;
-    std::vector<std::vector<uint8_t>> dirty; // dirty flags per cell
-    int currentZ = 0; // z for subsequent draw operations
-    size_t dirtyCount = 0; // total number of dirty cells
+    // Double buffering: drawing goes to the base layer or a surface, render() composites the layers
+    // into screenBuffer (back), diffs it against frontBuffer (what the terminal currently shows) and
+    // emits only cells that really changed.
+    std::vector<cell> screenBuffer; // back buffer, row-major, rows*cols cells
+    std::vector<cell> frontBuffer;  // last emitted frame, same layout
+    std::vector<uint64_t> backRowHash;  // XOR of cellHash over each back row
+    std::vector<uint64_t> frontRowHash; // same for the front rows; equal hashes => row skipped
+    int currentZ = 0; // z for subsequent draw operations, within the target layer
+    bool pendingChanges = true; // something was drawn or invalidated since the last render()
+
+    // Counters for the most recent render() call
+    struct renderStats {
+        size_t rowsScanned = 0;   // rows whose hash differed and were compared cell by cell
+        size_t cellsEmitted = 0;  // glyphs written to the terminal
+        size_t bytesEmitted = 0;  // escape sequences + glyph bytes written
+        size_t regionsScrolled = 0; // scroll hints turned into terminal scrolls
+        size_t framesDropped = 0;   // a frame the writer thread never got to, folded into this one
+    };
+    renderStats lastFrame;
+    // Where one frame's time went, from the end of the previous render() to the end of this one,
+    // in microseconds. Measured on every frame; render() closes it.
+    struct frameProfile {
+        struct containerCost {
+            const container* c;
+            double us; // drawing its box, label and elements (layout not included)
+        };
+        double inputDecodeUs = 0;   // reading and decoding terminal input
+        double inputHandlersUs = 0; // key and paste handlers: application work such as queries
+        double callbacksUs = 0;     // timers and watched-fd callbacks
+        double layoutUs = 0;        // container and element layout (applyLayoutForFrame)
+        double drawUs = 0;          // every container's drawing; the sum of containers
+        std::vector<containerCost> containers; // in render order, only those that drew
+        double endOfFrameUs = 0;    // runEndOfFrame callbacks
+        double composeUs = 0;       // flattening the changed parts of the layers
+        double diffUs = 0;          // row hashes, scroll hints and the front buffer copy
+        double encodeUs = 0;        // turning changed cells into escape sequences
+        double writeUs = 0;         // the write syscalls, or handing the frame to the writer thread
+        double frameUs = 0;         // wall time since the previous frame closed, idle included
+        size_t dirtyRows = 0;       // rows whose content differed from the terminal's
+        size_t cellsEmitted = 0;
+        size_t bytes = 0;
+        bool skipped = false;       // held back while the terminal still had the last frame queued
+    };
+    inline const frameProfile& lastProfile() const { return profileDone; }
+    // Overlay lastProfile() in the top-right corner, above everything. Ctrl+P toggles it as well;
+    // CHRMATUI_HUD=1 turns it on at startup.
+    void setProfilerHud(bool on);
+    inline bool profilerHud() const { return hudOn; }
+    // Measurement hooks for containers
+    inline void profileLayout(double us) { profileCur.layoutUs += us; }
+    inline void profileContainer(const container* c, double us) {
+        profileCur.drawUs += us;
+        profileCur.containers.push_back({c, us});
+    }
+    // Terminal backpressure since startup
+    outputStats outputBackpressure() const;
     // End-of-frame callbacks to run after elements render and before final render()
     std::vector<std::function<void(TUImanager&)>> endOfFrameCallbacks;
+    frameEncoder encoder; // reused output arena for render()
+    styleTable styles;    // the colors behind every cell's style id
+    inputDecoder input;   // pollInput's ring buffer and escape-sequence state
+    // Retained mode: containers skip render() unless something in them was invalidated. false
+    // makes every container redraw everything on each pass, as before.
+    bool retainedMode = true;
+    // Frame passes completed (bumped by runEndOfFrame). Each surface records the pass it was last
+    // drawn in, and runEndOfFrame hides the autoHide ones that missed this pass, e.g. a container
+    // that is no longer rendered (a closed modal, a view that was swapped out).
+    unsigned long framePass = 1;
+    // Frame pacing: changes made within frameBudgetMs of the last emitted frame are held back and
+    // go out together in the next one. 0 emits every frame.
+    int frameBudgetMs = 16;
 
-    TUImanager(){
-        enableRawMode();
-        std::setbuf(stdout, nullptr);  // Disable stdio buffering
-        // Enable UTF-8 locale so mbrtowc/wcwidth work as expected
-        setlocale(LC_ALL, "");
-        getTerminalSize(rows, cols);
-    screenBuffer.resize(rows, std::vector<characterSpace>(cols));
-    dirty.assign(rows, std::vector<uint8_t>(cols, 1));
-        dirtyCount = static_cast<size_t>(rows) * static_cast<size_t>(cols);
-        std::cout << "[?25l" << std::flush;
-        userState = NAVIGATING;
-    }
+    // On the process's terminal
+    TUImanager() : ownedTerm(new ttyBackend) { attach(*ownedTerm); }
+    // On any backend, e.g. a headlessBackend; it must outlive the manager
+    explicit TUImanager(terminalBackend& backend) { attach(backend); }
 
     ~TUImanager(){
-        disableRawMode();
-        std::cout << "\x1b[?25h\x1b[0m\x1b[2J\x1b[H" << std::flush;
+        for (container* c : containers) c->trackedBy = nullptr;
+        for (surface* s : surfaces) s->owner = nullptr;
+        writer.stop();
+        drainOutput();
+        closeEventLoop();
+        term->close();
     }
 
+    inline terminalBackend& terminal() { return *term; }
+
+    // Reallocate every buffer for a new terminal size. Base layer content in the overlapping area
+    // is kept, new cells start out empty, and the next render() repaints every cell since the
+    // terminal may have reflowed or cleared its screen.
+    void resize(int newRows, int newCols);
+    // Apply a pending SIGWINCH: re-read the terminal size and resize() if it changed. Returns true
+    // when the size changed; percent-laid-out containers follow on their next render().
+    bool checkResize();
+    // Fill the base layer with blanks; surfaces stay where they are
     void clearScreen(color col);
-    // Clear a rectangular region of the internal buffer and mark cells dirty.
+    // Clear a rectangular region of the draw target and mark cells dirty.
     void clearRect(int x, int y, int width, int height, color bg);
     void render();
-    // Polls input and updates internal state. Returns true if the app should close.
+    // Optional writer thread: render() encodes as usual but hands the bytes to a thread that writes
+    // them to the terminal, and returns without waiting for the terminal. A frame the terminal has not
+    // taken yet when the next one is ready is dropped; its rows are repainted by the newer frame.
+    void setWriterThread(bool on);
+    inline bool writerThread() const { return writer.running(); }
+    // Optional parallel encoding for big terminals: render() splits the screen into row bands that
+    // `threads` workers and the calling thread diff and encode into arenas of their own, then splices
+    // them in order into the frame's single write. The bytes are the same as encoding serially.
+    // Frames with fewer changed cells than a full repaint of a large terminal stay serial. Off (0)
+    // by default.
+    void setParallelEncode(int threads);
+    inline int parallelEncode() const { return pool.workers(); }
+    // Decodes everything the terminal has sent and delivers it as one batch (a held arrow key
+    // arrives as a single counted move). Returns true if the app should close.
     bool pollInput();
     // Block until input or timeout (ms). Returns true if input is ready, false on timeout.
+    // Same as waitEvents: timers, watched fds and resizes are serviced while waiting.
     bool waitForInput(int timeoutMs);
+
+    // Event loop (epoll): stdin, a timerfd for every timer, the SIGWINCH signalfd and any fds the
+    // application watches. Blocks until one of them needs attention or timeoutMs passes (-1: no
+    // limit), runs due timers, fd callbacks and checkResize(), and returns true when stdin has
+    // input. Nothing runs while idle.
+    bool waitEvents(int timeoutMs = -1);
+    // Run fn once after delayMs, then every repeatMs if that is > 0. Returns an id for cancelTimer.
+    int addTimer(int delayMs, std::function<void(TUImanager&)> fn, int repeatMs = 0);
+    void cancelTimer(int id);
+    // Call onReadable from waitEvents whenever fd is readable (a worker's eventfd, a socket...)
+    void watchFd(int fd, std::function<void(TUImanager&)> onReadable);
+    void unwatchFd(int fd);
     // Backwards-compatible name (deprecated): calls pollInput().
     bool windowShouldClose();
     // Schedule a function to run at the end of the current frame, before render().
     inline void enqueueEndOfFrame(std::function<void(TUImanager&)> fn) { endOfFrameCallbacks.push_back(std::move(fn)); }
     // Run and clear all end-of-frame callbacks.
     inline void runEndOfFrame() {
+        const auto start = std::chrono::steady_clock::now();
         for (auto &fn : endOfFrameCallbacks) { fn(*this); }
         endOfFrameCallbacks.clear();
+        retireSurfaces();
+        ++framePass;
+        profileCur.endOfFrameUs += usSince(start);
     }
     
+    // Direct access to a composited cell, as of the last render() (no bounds checking)
+    inline cell& cellAt(int x, int y) { return screenBuffer[static_cast<size_t>(y) * cols + x]; }
+    inline const cell& cellAt(int x, int y) const { return screenBuffer[static_cast<size_t>(y) * cols + x]; }
+
+    // characterSpace is kept as the public exchange type; it is converted to/from the compact cell.
     characterSpace getCharacter(int x, int y);
     void drawCharacter(characterSpace, int x, int y);
+    // Draw a single glyph (up to 4 UTF-8 bytes; len 0 draws a placeholder) without any allocation.
+    // width is the number of columns the glyph covers; callers fill the extra columns with placeholders.
+    void drawGlyph(const char* utf8, int len, color fg, color bg, int x, int y, int width = 1);
     void drawString(const std::string& str, color fg, color bg, int x, int y);
     // Draw a rounded box using Unicode characters. x,y are top-left, width/height in character cells.
     void drawBox(int x, int y, int width, int height, color borderFg, color borderBg, color fillBg);
+
+    // Rectangle primitives. They work a row at a time, skip cells above currentZ like drawGlyph and
+    // composite bg alpha the same way (0 keeps, 255 replaces, anything else blends).
+    void fillRect(int x, int y, int width, int height, color fg, color bg, const char* utf8 = " ", int len = 1);
+    // Blend fg and bg of the cells already there toward tint by tint.a, keeping their glyphs
+    void blendRect(int x, int y, int width, int height, color tint);
+    // Fill with spaces whose bg runs from `from` to `to` (left to right, or top to bottom); alpha is from.a
+    void gradientRect(int x, int y, int width, int height, color from, color to, bool horizontal = true);
        
     // Measure how many terminal columns a UTF-8 string will occupy
     int measureColumns(const std::string& str);
@@ -331,13 +1023,203 @@ class TUImanager{
     // Z control helpers
     inline void setCurrentZ(int z) { currentZ = z; }
     inline int getCurrentZ() const { return currentZ; }
-    inline bool hasDirty() const { return dirtyCount > 0; }
+    inline bool hasDirty() const { return pendingChanges; }
+    // True once the frame budget has passed since the last emitted frame. render() still skips
+    // the frame while the previous one is queued (see outputBackpressure).
+    bool frameDue() const;
+    // Milliseconds until frameDue() turns true, 0 if it already is; -1 while the terminal has not
+    // taken the last frame yet (waitEvents resumes writing it and returns once it is out)
+    int msUntilFrameDue() const;
+    // Part of the last frame is still waiting for the terminal to accept it
+    inline bool outputQueued() const { return outStats.queuedBytes > 0; }
     
-    // Mark a rectangular region as dirty (needs redraw)
+    // Mark a rectangular region as dirty: its cells drop to z=-1 so anything may draw over them
+    // again. Nothing is re-emitted unless the redrawn content actually differs.
     void markDirty(int x, int y, int width, int height);
     
-    // Mark entire screen as dirty
+    // Forget what the terminal shows so the next render() repaints every cell
     void markAllDirty();
+
+    // Retained mode: containers overlapping the rectangle redraw in full on their next render().
+    // markDirty calls it.
+    void invalidateRect(const rect& r);
+    void invalidateAllContainers();
+    void trackContainer(container* c);
+    void untrackContainer(container* c);
+
+    // Drawn-bounds tracking: between beginTrack() and endTrack(), every cell a draw call touches
+    // grows the returned rectangle
+    inline void beginTrack() { tracking = true; trackedBounds = rect{}; }
+    inline rect endTrack() { tracking = false; return trackedBounds; }
+
+    // Widgets that scroll call this from render(): the cells in area now show what was dy rows
+    // further down before (dy < 0: further up). The next render() shifts the terminal's copy with
+    // a scroll region when that leaves fewer cells to write than repainting. Only a cost hint:
+    // the output is the same either way.
+    void hintScroll(const rect& area, int dy);
+
+    // Layers. Until endSurface(), every draw call goes to s, which covers area at stacking order z
+    // (equal z: the surface registered first is below) and is clipped to it. s is shown from now
+    // on; with autoHide it is hidden again at the end of a pass (runEndOfFrame) it was not drawn
+    // in, and a surface with a parent is only shown while the parent is. Returns true when s
+    // starts out blank (first use, or area changed) and everything in it has to be drawn.
+    bool beginSurface(surface& s, const rect& area, int z, bool autoHide = false, surface* parent = nullptr);
+    void endSurface();
+    // Stop showing s; what it covered is composited from the layers below on the next render()
+    void hideSurface(surface& s);
+    // The surface draw calls go to, nullptr for the base layer
+    inline surface* currentSurface() const { return targets.empty() ? nullptr : targets.back().s; }
+    // Make every cell of s transparent again, for owners that lay their content out anew
+    void clearSurface(surface& s);
+    void forgetSurface(surface& s); // surface destructor
+
+    // Switch output color depth; everything on screen is repainted in the new palette
+    void setColorDepth(colorDepth depth);
+
+    private:
+    // Store c at idx in the back buffer, keeping the row hash up to date
+    inline void storeCell(size_t idx, int x, int y, const cell& c) {
+        cell& dst = screenBuffer[idx];
+        backRowHash[y] ^= cellHash(dst, x) ^ cellHash(c, x);
+        dst = c;
+        pendingChanges = true;
+    }
+    // Draw target: the base layer or the innermost surface between beginSurface/endSurface.
+    // targetRow(y)[x] is the target's cell at screen (x, y) for x, y inside targetArea.
+    std::vector<cell> baseLayer; // rows*cols, what is drawn outside any surface
+    struct targetEntry { surface* s; bool tracking; };
+    std::vector<targetEntry> targets;
+    rect targetArea;             // the target's bounds clipped to the screen
+    inline cell* targetRow(int y) {
+        return targets.empty() ? &baseLayer[static_cast<size_t>(y) * cols] : targets.back().s->row(y);
+    }
+    // What a blend over target cell c at (x, y) mixes with: the layers below where the surface is still empty
+    inline const cell& underneath(const cell& c, int x, int y) const { return (c.flags & cellEmpty) ? layerBelow(x, y) : c; }
+    const cell& layerBelow(int x, int y) const; // topmost non-empty cell under the target
+    void retarget(); // targetArea for the new top of targets
+    // Changed columns [damageLo, damageHi) per row, composited by render()
+    std::vector<int> damageLo, damageHi;
+    inline void damage(int y, int x0, int x1) {
+        damageLo[y] = std::min(damageLo[y], x0);
+        damageHi[y] = std::max(damageHi[y], x1);
+        pendingChanges = true;
+    }
+    void damageRect(const rect& r); // clipped to the screen
+    void damageTree(const surface& s); // s and the surfaces shown through it
+    std::vector<surface*> surfaces;     // registration order
+    std::vector<surface*> layerScratch; // compose(): shown surfaces, top first
+    bool surfaceShown(const surface* s) const;
+    void retireSurfaces(); // runEndOfFrame: hide autoHide surfaces not drawn this pass
+    void compose();        // flatten the damaged cells into screenBuffer
+    // Style id for a packed fg/bg pair. When the table is full, the ids no cell uses any more are
+    // reclaimed first (gradients and blends can mint a new pair per cell). If every id is still
+    // on screen the pair is drawn in the closest colors that have one, until the next frame.
+    inline uint16_t styleOf(uint32_t fg, uint32_t bg) {
+        uint16_t id = styles.intern(fg, bg);
+        if (id == styleUnknown) {
+            if (!stylesFull && compactStyles()) id = styles.intern(fg, bg);
+            if (id == styleUnknown) {
+                stylesFull = true;
+                id = styles.nearest(fg, bg);
+            }
+        }
+        return id;
+    }
+    bool compactStyles(); // false if no id could be reclaimed
+    bool stylesFull = false; // compactStyles found nothing to reclaim this frame
+    std::vector<uint16_t> styleScratch; // compositeRow: the style ids of the row, cols entries
+    void recomputeRowHash(int y);
+    void invalidateFront();
+    std::unique_ptr<terminalBackend> ownedTerm; // the default ttyBackend
+    terminalBackend* term = nullptr;
+    void attach(terminalBackend& backend); // constructor body
+    // Deliver one event from pollInput's batch. Returns true if the app should close.
+    bool dispatchInput(const inputEvent& ev);
+    frameWriter writer;
+    // With the writer thread, what the terminal will show once it has written every frame it took.
+    // frontBuffer also counts the pending frame, whose rows are listed in publishedRows.
+    std::vector<cell> committedFront;
+    std::vector<uint64_t> committedRowHash;
+    std::vector<int> publishedRows;
+    std::vector<int> frameRows; // rows the frame being encoded touches
+    // Before encoding: withdraw a pending frame the writer has not taken and restore its rows in
+    // frontBuffer from committedFront, or, if it was taken, commit them
+    void reclaimFrame();
+    struct timerEntry {
+        int id;
+        std::chrono::steady_clock::time_point due;
+        int repeatMs;
+        std::function<void(TUImanager&)> fn;
+    };
+    struct watchEntry {
+        int fd;
+        std::function<void(TUImanager&)> onReadable;
+    };
+    int epollFd = -1;
+    int timerFd = -1;
+    bool watchingOutput = false; // the output fd is in the epoll set, waiting for EPOLLOUT
+    int nextTimerId = 1;
+    std::vector<timerEntry> timers;
+    std::vector<watchEntry> watches;
+    void initEventLoop();
+    void closeEventLoop();
+    void armTimerFd(); // program timerFd for the earliest timer, or disarm it
+    void runDueTimers();
+    // Non-blocking output: write as much of encoder.out as the terminal takes. What is left stays
+    // queued and the output fd is watched for EPOLLOUT, so waitEvents resumes it. Returns true once all is out.
+    bool flushOutput();
+    void drainOutput(); // block until the queue is written (shutdown, switching to the writer thread)
+    void watchOutput(bool on);
+    outputStats outStats; // queuedBytes: the tail of encoder.out still to be written
+    struct scrollHintEntry { rect area; int dy; };
+    std::vector<scrollHintEntry> scrollHints;
+    // Turn worthwhile scroll hints into terminal scrolls and shift frontBuffer to match. Returns
+    // true if it began the frame.
+    bool applyScrollHints();
+    // Bytes needed to repaint band if the terminal's copy were first shifted by dy rows
+    size_t bandCost(const rect& band, int dy);
+    frameEncoder costEncoder;       // scratch encoder for bandCost
+    std::vector<cell> scrollScratch; // one shifted front row
+    inline void track(int x, int y, int w, int h) { if (tracking) trackedBounds = trackedBounds.united({x, y, w, h}); }
+    bool tracking = false;
+    rect trackedBounds;
+    std::vector<container*> containers; // every container that has rendered with this manager
+    // Clip a rectangle to the draw target; false when nothing is left
+    bool clipRect(int& x, int& y, int& width, int& height) const;
+    // Write glyphCell's glyph in fg with bg[] composited by bgAlpha over columns [x, x+n) of row y.
+    // repeatRow: fg, bg[] and n are those of the previous call, so opaque rows reuse its style ids.
+    void compositeRow(int x, int y, int n, const cell& glyphCell, uint32_t fg, const uint32_t* bg, uint8_t bgAlpha,
+                      bool repeatRow = false);
+    std::chrono::steady_clock::time_point lastEmit{};
+    std::vector<uint32_t> rowScratch; // 3*cols packed colors for the rectangle primitives
+    frameProfile profileCur;  // the frame being measured
+    frameProfile profileDone; // the last closed one
+    std::chrono::steady_clock::time_point profileStart = std::chrono::steady_clock::now();
+    void renderFrame();  // render() without the profiling around it
+    // A band of the parallel encoder: rows [y0, y1) encoded on their own from an unknown cursor and
+    // SGR state, and where that encoder stood after each changed row
+    struct bandRow {
+        int y;
+        size_t end;   // enc.out's size after the row
+        size_t cells; // what encodeRow returned
+        frameEncoder::state after;
+    };
+    struct rowBand {
+        int y0 = 0, y1 = 0;
+        frameEncoder enc;
+        frameEncoder::state entry{};
+        std::vector<bandRow> rows; // the changed rows, top to bottom
+    };
+    std::vector<rowBand> bands;
+    bandPool pool;
+    // renderFrame's row loop on the pool. False, having done nothing, when too few cells changed.
+    bool encodeBands(bool& started);
+    bool changedCellsReach(size_t limit) const; // at least limit cells differ from frontBuffer
+    void encodeBand(rowBand& b); // on a worker
+    void closeProfile(); // end of render(): profileCur becomes lastProfile()
+    bool hudOn = false;
+    surface hudLayer;
+    void drawHud(); // start of render(), showing the previous frame
 };
 
 #endif // CHRMA_TUI_HPP
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "chrmaTUI.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHRMA_X86 1
+#endif
+
+namespace {
+
+void blendRowScalar(uint32_t* dst, const uint32_t* src, size_t n, uint8_t a) {
+    for (size_t i = 0; i < n; ++i) dst[i] = blendPacked(dst[i], src[i], a);
+}
+
+#ifdef CHRMA_X86
+// Four packed colors per iteration: widen the bytes to 16-bit lanes, dst*(255-a) + src*a, then the
+// same exact /255 as blendPacked. The unused top byte is 0 in both inputs and stays 0.
+__attribute__((target("sse2")))
+void blendRowSSE2(uint32_t* dst, const uint32_t* src, size_t n, uint8_t a) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i va = _mm_set1_epi16(a);
+    const __m128i vinv = _mm_set1_epi16(static_cast<short>(255 - a));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), vinv),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), va));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), vinv),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), va));
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blendRowScalar(dst + i, src + i, n - i, a);
+}
+
+// Same as the SSE2 kernel on eight colors; unpack and pack both work per 128-bit lane, so the
+// order comes out unchanged
+__attribute__((target("avx2")))
+void blendRowAVX2(uint32_t* dst, const uint32_t* src, size_t n, uint8_t a) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i va = _mm256_set1_epi16(a);
+    const __m256i vinv = _mm256_set1_epi16(static_cast<short>(255 - a));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), vinv),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), va));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), vinv),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), va));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    blendRowSSE2(dst + i, src + i, n - i, a);
+}
+#endif
+
+using blendRowFn = void (*)(uint32_t*, const uint32_t*, size_t, uint8_t);
+
+blendRowFn pickBlendRow() {
+#ifdef CHRMA_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return blendRowAVX2;
+    if (__builtin_cpu_supports("sse2")) return blendRowSSE2;
+#endif
+    return blendRowScalar;
+}
+
+const blendRowFn kBlendRow = pickBlendRow();
+}
+
+void blendPackedRow(uint32_t* dst, const uint32_t* src, size_t n, uint8_t a) {
+    if (a == 0) return;
+    if (a == 255) { std::memcpy(dst, src, n * sizeof(uint32_t)); return; }
+    kBlendRow(dst, src, n, a);
+}
+
+bool TUImanager::clipRect(int& x, int& y, int& width, int& height) const {
+    const rect r = rect{x, y, width, height}.intersected(targetArea);
+    x = r.x;
+    y = r.y;
+    width = r.w;
+    height = r.h;
+    return !r.empty();
+}
+
+void TUImanager::compositeRow(int x, int y, int n, const cell& glyphCell, uint32_t fg, const uint32_t* bg, uint8_t bgAlpha,
+                              bool repeatRow) {
+    track(x, y, n, 1);
+    cell* row = targetRow(y);
+    uint16_t* ids = styleScratch.data();
+    if (bgAlpha != 255 || !repeatRow) {
+        const uint32_t* finalBg = bg;
+        if (bgAlpha != 255) {
+            uint32_t* mixed = rowScratch.data() + cols;
+            for (int i = 0; i < n; ++i) mixed[i] = styles.bg(underneath(row[x + i], x + i, y).style);
+            blendPackedRow(mixed, bg, static_cast<size_t>(n), bgAlpha);
+            finalBg = mixed;
+        }
+        // Runs of one color share the lookup. A compaction halfway renumbers ids[] along with the cells.
+        for (int i = 0; i < n; ++i) ids[i] = i > 0 && finalBg[i] == finalBg[i - 1] ? ids[i - 1] : styleOf(fg, finalBg[i]);
+    }
+    cell next = glyphCell;
+    next.z = static_cast<int16_t>(currentZ);
+    int lo = x + n, hi = x;
+    for (int i = 0; i < n; ++i) {
+        cell& existing = row[x + i];
+        if (currentZ < existing.z) continue;
+        next.style = ids[i];
+        if (std::memcmp(&next, &existing, sizeof(cell)) == 0) continue;
+        existing = next;
+        lo = std::min(lo, x + i);
+        hi = x + i + 1;
+    }
+    if (lo < hi) damage(y, lo, hi);
+}
+
+void TUImanager::fillRect(int x, int y, int width, int height, color fg, color bg, const char* utf8, int len) {
+    if (!clipRect(x, y, width, height)) return;
+    cell glyphCell{};
+    len = std::max(0, std::min(len, 4));
+    if (len > 0) std::memcpy(glyphCell.glyph, utf8, static_cast<size_t>(len));
+    glyphCell.glyphLen = static_cast<uint8_t>(len);
+    uint32_t* src = rowScratch.data();
+    std::fill(src, src + width, packColor(bg));
+    for (int yy = y; yy < y + height; ++yy) compositeRow(x, yy, width, glyphCell, packColor(fg), src, bg.a, yy > y);
+}
+
+void TUImanager::blendRect(int x, int y, int width, int height, color tint) {
+    if (tint.a == 0 || !clipRect(x, y, width, height)) return;
+    track(x, y, width, height);
+    uint32_t* src = rowScratch.data();
+    uint32_t* fgs = src + cols;
+    uint32_t* bgs = src + 2 * cols;
+    std::fill(src, src + width, packColor(tint));
+    for (int yy = y; yy < y + height; ++yy) {
+        cell* row = targetRow(yy);
+        for (int i = 0; i < width; ++i) {
+            const uint16_t under = underneath(row[x + i], x + i, yy).style;
+            fgs[i] = styles.fg(under);
+            bgs[i] = styles.bg(under);
+        }
+        blendPackedRow(fgs, src, static_cast<size_t>(width), tint.a);
+        blendPackedRow(bgs, src, static_cast<size_t>(width), tint.a);
+        int lo = x + width, hi = x;
+        for (int i = 0; i < width; ++i) {
+            cell& existing = row[x + i];
+            if (currentZ < existing.z) continue;
+            // On a surface cell nothing has drawn to yet, the tint goes over a copy of what shows through
+            cell next = underneath(existing, x + i, yy);
+            next.style = styleOf(fgs[i], bgs[i]);
+            next.z = static_cast<int16_t>(currentZ);
+            if (std::memcmp(&next, &existing, sizeof(cell)) == 0) continue;
+            existing = next;
+            lo = std::min(lo, x + i);
+            hi = x + i + 1;
+        }
+        if (lo < hi) damage(yy, lo, hi);
+    }
+}
+
+void TUImanager::gradientRect(int x, int y, int width, int height, color from, color to, bool horizontal) {
+    const int steps = std::max(1, (horizontal ? width : height) - 1);
+    auto lerp = [&](int i) {
+        auto ch = [&](uint8_t a, uint8_t b) { return static_cast<uint8_t>(a + (int(b) - int(a)) * i / steps); };
+        return (uint32_t(ch(from.r, to.r)) << 16) | (uint32_t(ch(from.g, to.g)) << 8) | ch(from.b, to.b);
+    };
+    const int offX = x, offY = y; // gradient positions are relative to the unclipped rectangle
+    if (!clipRect(x, y, width, height)) return;
+    cell space{};
+    space.glyph[0] = ' ';
+    space.glyphLen = 1;
+    uint32_t* src = rowScratch.data();
+    if (horizontal) {
+        for (int i = 0; i < width; ++i) src[i] = lerp(x - offX + i);
+    }
+    for (int yy = y; yy < y + height; ++yy) {
+        if (!horizontal) std::fill(src, src + width, lerp(yy - offY));
+        compositeRow(x, yy, width, space, 0, src, from.a, horizontal && yy > y);
+    }
+}
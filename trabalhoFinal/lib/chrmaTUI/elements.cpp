@@ -130,15 +130,7 @@ void InputBar::render(TUImanager& tui) {
     bool showCursor = (tui.userState == CAPTURE && isHovered);
     
     int fieldWidth = totalWidth - 2; // Account for borders
-    for (int i = 0; i < fieldWidth; ++i) {
-        characterSpace cs{};
-        cs.character = ' ';
-        cs.colorForeground = useFg;
-        cs.colorBackground = fieldBg;
-        cs.z = 0;
-        cs.utf8.clear();
-        tui.drawCharacter(cs, renderPos.x + 1 + i, renderPos.y + 1);
-    }
+    tui.fillRect(renderPos.x + 1, renderPos.y + 1, fieldWidth, 1, useFg, fieldBg);
     
     // Draw the text content
     if (!renderText.empty()) {
@@ -157,6 +149,11 @@ void InputBar::render(TUImanager& tui) {
     }
 }
 
+void InputBar::setText(const std::string& t) {
+    text = t;
+    invalidate();
+}
+
 void InputBar::onHover(bool hovered) {
     isHovered = hovered;
 }
@@ -176,6 +173,34 @@ void InputBar::onInteract(pressedKey key, char c, uint8_t& userState, TUImanager
     }
 }
 
+void InputBar::onPaste(const char* s, size_t len, uint8_t& /*userState*/, TUImanager& /*tui*/) {
+    // Line breaks become spaces since the bar is one line, other ASCII controls are dropped and
+    // UTF-8 is kept whole. The limit is in columns, counted like drawString does.
+    const int limit = std::max(0, size.x - 2);
+    int used = utf8Columns(text.data(), text.size());
+    for (size_t i = 0; i < len;) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c < 0x80) {
+            if (c == '\r' && i + 1 < len && s[i + 1] == '\n') { ++i; continue; }
+            if (c == '\r' || c == '\n' || c == '\t') c = ' ';
+            ++i;
+            if (c < 0x20 || c == 0x7F) continue;
+            if (used + 1 > limit) break;
+            text += static_cast<char>(c);
+            ++used;
+            continue;
+        }
+        char32_t cp;
+        const int n = decodeUtf8(s + i, len - i, cp);
+        if (cp == 0xFFFD && n == 1) { ++i; continue; } // not UTF-8
+        const int w = std::max(1, glyphWidth(cp));
+        if (used + w > limit) break;
+        text.append(s + i, static_cast<size_t>(n));
+        used += w;
+        i += static_cast<size_t>(n);
+    }
+}
+
 // --- Slider Implementation ---
 Slider::Slider(float min, float max, float initialValue, float step, point pos, int w, int h)
     : value(initialValue), step(step), minValue(min), maxValue(max) {
@@ -371,8 +396,9 @@ void RadioButton::onInteract(pressedKey key, char /*c*/, uint8_t& userState, TUI
         if (parent) {
             for (element* el : parent->elements) {
                 RadioButton* rb = dynamic_cast<RadioButton*>(el);
-                if (rb && rb != this && rb->group == group) {
+                if (rb && rb != this && rb->group == group && rb->selected) {
                     rb->selected = false;
+                    rb->invalidate();
                 }
             }
         }
@@ -387,6 +413,7 @@ void DropdownMenu::render(TUImanager& tui) {
     color selectedBg = {120, 120, 120, 255};
     
     if (!isOpen) {
+        tui.hideSurface(popup);
         // Closed state - draw just the header box (3 rows tall like selector)
         tui.drawBox(renderPos.x, renderPos.y, size.x, 3, useFg, useBg, style.bg);
         
@@ -406,6 +433,9 @@ void DropdownMenu::render(TUImanager& tui) {
     } else {
         // Open state - draw expanded dropdown with all options
         int dropdownHeight = std::min((int)options.size() + 2, maxOpenHeight); // Use maxOpenHeight
+        // The list goes on its own surface just above the container, so it can reach past the
+        // container's edge and closing it uncovers whatever was there untouched
+        tui.beginSurface(popup, {renderPos.x, renderPos.y, size.x, dropdownHeight}, tui.getCurrentZ() + 1, false, tui.currentSurface());
         tui.drawBox(renderPos.x, renderPos.y, size.x, dropdownHeight, useFg, useBg, style.bg);
         
         // Draw label with curly brackets at the top
@@ -480,6 +510,7 @@ void DropdownMenu::render(TUImanager& tui) {
             // Draw bottom arrow
             tui.drawString("▼", useFg, useBg, scrollbarX, renderPos.y + dropdownHeight - 2);
         }
+        tui.endSurface();
     }
 }
 
@@ -530,7 +561,7 @@ int Text::measureTextWidth(const std::string& text, TUImanager& tui) const {
 }
 
 // Helper function to wrap text into lines based on maxWidth
-std::vector<std::string> Text::wrapText(const std::string& text, int maxWidth, TUImanager& tui) const {
+std::vector<std::string> Text::wrapText(const std::string& text, int maxWidth, TUImanager& /*tui*/) const {
     std::vector<std::string> lines;
     if (maxWidth <= 0) {
         lines.push_back(text);
@@ -546,6 +577,8 @@ std::vector<std::string> Text::wrapText(const std::string& text, int maxWidth, T
         size_t lineEnd = start;
         size_t lastSpace = std::string::npos;
         
+        int width = 0;
+        
         // Process characters until we reach maxWidth or end of text
         while (end < text.length()) {
             // Check for explicit line breaks
@@ -560,25 +593,29 @@ std::vector<std::string> Text::wrapText(const std::string& text, int maxWidth, T
                 lastSpace = end;
             }
             
-            // Temporarily extend the line to check its width
-            size_t tempEnd = end + 1;
-            std::string tempLine = text.substr(start, tempEnd - start);
-            int width = measureTextWidth(tempLine, tui);
+            // Extend the line by one code point, keeping a running width instead of re-measuring
+            char32_t cp;
+            size_t tempEnd = end + static_cast<size_t>(decodeUtf8(text.data() + end, text.length() - end, cp));
+            int charWidth = std::max(1, glyphWidth(cp));
             
             // If we've exceeded the max width
-            if (width > maxWidth) {
+            if (width + charWidth > maxWidth) {
                 // If we found a space, break there
                 if (lastSpace != std::string::npos && lastSpace > start) {
                     lineEnd = lastSpace;
                     end = lastSpace + 1; // Skip the space
-                } else {
+                } else if (end > start) {
                     // No space found, break at the previous character
-                    lineEnd = (end > start) ? end : start + 1;
-                    if (lineEnd > text.length()) lineEnd = text.length();
+                    lineEnd = end;
+                } else {
+                    // A single character wider than the line still has to go somewhere
+                    lineEnd = tempEnd;
+                    end = tempEnd;
                 }
                 break;
             }
             
+            width += charWidth;
             lineEnd = tempEnd;
             end = tempEnd;
         }
@@ -647,7 +684,7 @@ void Text::render(TUImanager& tui) {
 }
 
 // --- MultiLineInput Implementation ---
-MultiLineInput::Wrapped MultiLineInput::wrap(const std::string& t, int maxWidth, TUImanager& tui) const {
+MultiLineInput::Wrapped MultiLineInput::wrap(const std::string& t, int maxWidth, TUImanager& /*tui*/) const {
     Wrapped w{};
     if (maxWidth <= 0) {
         // Fallback: each character on its own line
@@ -698,10 +735,13 @@ MultiLineInput::Wrapped MultiLineInput::wrap(const std::string& t, int maxWidth,
             int segmentStart = i;
             int lastSpace = -1;
             
-            // Find the longest segment that fits
+            int width = 0;
+            
+            // Find the longest segment that fits, one code point at a time
             while (i < n) {
-                std::string candidate = line.substr(segmentStart, i - segmentStart + 1);
-                int width = tui.measureColumns(candidate);
+                char32_t cp;
+                int charLen = decodeUtf8(line.data() + i, static_cast<size_t>(n - i), cp);
+                width += std::max(1, glyphWidth(cp));
                 
                 if (width > maxWidth && i > segmentStart) {
                     // Too wide, break here
@@ -711,7 +751,7 @@ MultiLineInput::Wrapped MultiLineInput::wrap(const std::string& t, int maxWidth,
                 if (std::isspace(static_cast<unsigned char>(line[i]))) {
                     lastSpace = i;
                 }
-                i++;
+                i += charLen;
             }
             
             // Decide where to break
@@ -738,6 +778,24 @@ MultiLineInput::Wrapped MultiLineInput::wrap(const std::string& t, int maxWidth,
     return w;
 }
 
+const MultiLineInput::Wrapped& MultiLineInput::wrapForBox(int w, int innerH, int& contentWidth, TUImanager& tui) const {
+    WrapCache& c = wrapCache;
+    if (c.w != w || c.innerH != innerH || c.text != text) {
+        c.wrapped = wrap(text, std::max(1, w - 2), tui);
+        c.contentWidth = w - 2;
+        // Re-wrap with room for the scrollbar if the lines do not fit
+        if (static_cast<int>(c.wrapped.lines.size()) > innerH) {
+            c.wrapped = wrap(text, std::max(1, w - 3), tui);
+            if (static_cast<int>(c.wrapped.lines.size()) > innerH) c.contentWidth = w - 3;
+        }
+        c.text = text;
+        c.w = w;
+        c.innerH = innerH;
+    }
+    contentWidth = c.contentWidth;
+    return c.wrapped;
+}
+
 std::pair<int,int> MultiLineInput::caretWrappedPos(const Wrapped& w) const {
     if (w.lines.empty()) return {0, 0};
     
@@ -770,6 +828,26 @@ std::pair<int,int> MultiLineInput::caretWrappedPos(const Wrapped& w) const {
     return {lastLine, lastCol};
 }
 
+void MultiLineInput::startBlink(TUImanager& tui) {
+    if (blinkTimer >= 0) return;
+    blinkTui = &tui;
+    // Nothing redraws an idle input, so the timer drives the blink. Skip a tick that comes
+    // right after an edit, which already reset the caret to visible.
+    blinkTimer = tui.addTimer(500, [this](TUImanager&) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastBlinkTime < std::chrono::milliseconds(450)) return;
+        cursorVisible = !cursorVisible;
+        lastBlinkTime = now;
+        invalidate();
+    }, 500);
+}
+
+void MultiLineInput::stopBlink() {
+    if (blinkTimer < 0) return;
+    blinkTui->cancelTimer(blinkTimer);
+    blinkTimer = -1;
+}
+
 void MultiLineInput::render(TUImanager& tui) {
     color useFg = isHovered ? style.fgHi : style.fg;
     color useBg = isHovered ? style.bgHi : style.bg;
@@ -783,22 +861,12 @@ void MultiLineInput::render(TUImanager& tui) {
     std::string labelText = "{" + label + "}";
     tui.drawString(labelText, useFg, {0,0,0,0}, renderPos.x + 1, renderPos.y);
 
-    // Content area - check if we need scrollbar
+    // Content area - leaves a column for the scrollbar if needed
     int innerH = h - 2; // content rows
-    Wrapped wrapped = wrap(text, std::max(1, w - 2), tui);
+    int contentWidth = 0;
+    const Wrapped& wrapped = wrapForBox(w, innerH, contentWidth, tui);
     int totalLines = static_cast<int>(wrapped.lines.size());
     bool needsScrollbar = totalLines > innerH;
-    int scrollbarWidth = needsScrollbar ? 1 : 0;
-    int contentWidth = w - 2 - scrollbarWidth; // Leave space for scrollbar if needed
-    
-    // Re-wrap with correct content width if scrollbar is needed
-    if (needsScrollbar) {
-        wrapped = wrap(text, std::max(1, contentWidth), tui);
-    }
-    totalLines = static_cast<int>(wrapped.lines.size());
-    needsScrollbar = totalLines > innerH; // Re-check after rewrapping
-    scrollbarWidth = needsScrollbar ? 1 : 0;
-    contentWidth = w - 2 - scrollbarWidth;
 
     // Ensure caret is visible: compute wrapped position and adjust scrollY
     auto [cLine, cCol] = caretWrappedPos(wrapped);
@@ -811,13 +879,7 @@ void MultiLineInput::render(TUImanager& tui) {
     for (int row = 0; row < innerH; ++row) {
         int ly = scrollY + row;
         // clear line background
-        for (int col = 0; col < contentWidth; ++col) {
-            characterSpace cs{};
-            cs.character = ' ';
-            cs.colorForeground = useFg;
-            cs.colorBackground = useBg;
-            tui.drawCharacter(cs, renderPos.x + 1 + col, renderPos.y + 1 + row);
-        }
+        tui.fillRect(renderPos.x + 1, renderPos.y + 1 + row, contentWidth, 1, useFg, useBg);
         if (ly >= 0 && ly < totalLines) {
             std::string line = wrapped.lines[ly];
             // trim to width
@@ -862,14 +924,7 @@ void MultiLineInput::render(TUImanager& tui) {
 
     // Draw blinking caret if in capture mode
     if (tui.userState == CAPTURE && isHovered) {
-        // Update cursor blink state
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastBlinkTime);
-        if (elapsed.count() >= 500) { // Blink every 500ms
-            cursorVisible = !cursorVisible;
-            lastBlinkTime = now;
-        }
-        
+        startBlink(tui);
         if (cursorVisible) {
             int caretRow = cLine - scrollY;
             if (caretRow >= 0 && caretRow < innerH) {
@@ -885,6 +940,8 @@ void MultiLineInput::render(TUImanager& tui) {
         int helpX = renderPos.x + w - static_cast<int>(helpText.length()) - 1;
         if (helpX < renderPos.x + 1) helpX = renderPos.x + 1; // Don't go past left border
         tui.drawString(helpText, useFg, {0,0,0,0}, helpX, helpY);
+    } else {
+        stopBlink();
     }
 }
 
@@ -892,6 +949,8 @@ void MultiLineInput::onInteract(pressedKey key, char c, uint8_t& userState, TUIm
     // Exit capture on ESC
     if (key == ESC) {
         userState = NAVIGATING;
+        stopBlink();
+        cursorVisible = true;
         notifyCaptureEnd(tui);
         return;
     }
@@ -923,12 +982,8 @@ void MultiLineInput::onInteract(pressedKey key, char c, uint8_t& userState, TUIm
         // Move by wrapped line preserving column
         int w = std::max(size.x, 6);
         int h = std::max(size.y, 3);
-        int innerH = h - 2;
-        Wrapped tempWrapped = wrap(text, std::max(1, w - 2), tui);
-        bool needsScrollbar = static_cast<int>(tempWrapped.lines.size()) > innerH;
-        int contentWidth = w - 2 - (needsScrollbar ? 1 : 0);
-        
-        Wrapped wrapped = wrap(text, std::max(1, contentWidth), tui);
+        int contentWidth = 0;
+        const Wrapped& wrapped = wrapForBox(w, h - 2, contentWidth, tui);
         auto [line, col] = caretWrappedPos(wrapped);
         int target = (key == UP) ? line - 1 : line + 1;
         if (target >= 0 && target < (int)wrapped.lines.size()) {
@@ -973,6 +1028,26 @@ void MultiLineInput::onInteract(pressedKey key, char c, uint8_t& userState, TUIm
     }
 }
 
+void MultiLineInput::onPaste(const char* s, size_t len, uint8_t& /*userState*/, TUImanager& /*tui*/) {
+    // Drop ASCII controls but keep UTF-8 bytes, with CR/CRLF line breaks as newlines, then insert
+    // it all at once
+    std::string insert;
+    insert.reserve(len);
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == '\r') {
+            if (i + 1 < len && s[i + 1] == '\n') continue;
+            c = '\n';
+        }
+        if (c == '\n' || (c >= 0x20 && c != 0x7F)) insert += static_cast<char>(c);
+    }
+    const int at = std::min(caretIndex, (int)text.size());
+    text.insert(static_cast<size_t>(at), insert);
+    caretIndex = at + static_cast<int>(insert.size());
+    cursorVisible = true;
+    lastBlinkTime = std::chrono::steady_clock::now();
+}
+
 // --- ListView Implementation ---
 ListView::ListView(const std::string& lbl, const std::vector<std::string>& itemList, point pos, int w, int h, int visibleRows)
     : items(itemList), selectedIndex(0), label(lbl), visibleRows(visibleRows), scrollOffset(0) {
@@ -1008,7 +1083,8 @@ void ListView::render(TUImanager& tui) {
     tui.drawString(labelText, useFg, {0,0,0,0}, renderPos.x + 1, renderPos.y);
     
     // Calculate scrolling parameters
-    bool needsScrollbar = (int)items.size() > actualVisibleRows;
+    const int total = itemCount();
+    bool needsScrollbar = total > actualVisibleRows;
     int scrollbarWidth = needsScrollbar ? 1 : 0;
     int contentWidth = size.x - 2 - scrollbarWidth; // Account for borders and scrollbar
     
@@ -1021,14 +1097,23 @@ void ListView::render(TUImanager& tui) {
     }
     
     // Clamp scroll offset
-    int maxScroll = std::max(0, (int)items.size() - actualVisibleRows);
+    int maxScroll = std::max(0, total - actualVisibleRows);
     if (scrollOffset > maxScroll) scrollOffset = maxScroll;
     if (scrollOffset < 0) scrollOffset = 0;
     
+    // Item rows that moved can be shifted on the terminal instead of repainted
+    rect itemArea{renderPos.x + 1, renderPos.y + 1, contentWidth, actualVisibleRows};
+    if (lastScrollOffset >= 0 && scrollOffset != lastScrollOffset && itemArea == lastItemArea) {
+        tui.hintScroll(itemArea, scrollOffset - lastScrollOffset);
+    }
+    lastScrollOffset = scrollOffset;
+    lastItemArea = itemArea;
+    
     // Draw items
-    for (int i = 0; i < actualVisibleRows && (scrollOffset + i) < (int)items.size(); ++i) {
+    materialize(scrollOffset, actualVisibleRows);
+    for (int i = 0; i < actualVisibleRows && (scrollOffset + i) < total; ++i) {
         int itemIndex = scrollOffset + i;
-        std::string itemText = items[itemIndex];
+        std::string itemText = rowText(itemIndex);
         
         // Truncate if too long
         if ((int)itemText.length() > contentWidth - 2) {
@@ -1049,13 +1134,7 @@ void ListView::render(TUImanager& tui) {
         std::string displayText = (itemIndex == selectedIndex) ? ">" + itemText : " " + itemText;
         
         // Clear the line background first
-        for (int col = 0; col < contentWidth; ++col) {
-            characterSpace cs{};
-            cs.character = ' ';
-            cs.colorForeground = itemFg;
-            cs.colorBackground = itemBg;
-            tui.drawCharacter(cs, renderPos.x + 1 + col, renderPos.y + 1 + i);
-        }
+        tui.fillRect(renderPos.x + 1, renderPos.y + 1 + i, contentWidth, 1, itemFg, itemBg);
         
         tui.drawString(displayText, itemFg, itemBg, renderPos.x + 1, renderPos.y + 1 + i);
     }
@@ -1072,8 +1151,8 @@ void ListView::render(TUImanager& tui) {
         // Calculate scrollbar thumb position and size
         int trackHeight = scrollbarHeight - 2; // Reserve space for arrows
         if (trackHeight > 0) {
-            float scrollRatio = (float)scrollOffset / std::max(1, (int)items.size() - actualVisibleRows);
-            float thumbSize = std::max(1.0f, (float)trackHeight * actualVisibleRows / items.size());
+            float scrollRatio = (float)scrollOffset / std::max(1, total - actualVisibleRows);
+            float thumbSize = std::max(1.0f, (float)trackHeight * actualVisibleRows / total);
             int thumbPos = (int)(scrollRatio * (trackHeight - thumbSize));
             
             // Draw scrollbar track
@@ -1094,7 +1173,7 @@ void ListView::render(TUImanager& tui) {
     
     // Show item count at bottom
     char countStr[32];
-    snprintf(countStr, sizeof(countStr), "%d/%d", selectedIndex + 1, (int)items.size());
+    snprintf(countStr, sizeof(countStr), "%d/%d", selectedIndex + 1, total);
     tui.drawString(countStr, useFg, {0,0,0,0}, renderPos.x + 1, renderPos.y + totalHeight - 1);
 }
 
@@ -1110,11 +1189,11 @@ void ListView::onInteract(pressedKey key, char /*c*/, uint8_t& userState, TUIman
     } else if (key == UP) {
         selectedIndex--;
         if (selectedIndex < 0) {
-            selectedIndex = (int)items.size() - 1;
+            selectedIndex = itemCount() - 1;
         }
     } else if (key == DOWN) {
         selectedIndex++;
-        if (selectedIndex >= (int)items.size()) {
+        if (selectedIndex >= itemCount()) {
             selectedIndex = 0;
         }
     } else if (key == ESC) {
@@ -1123,14 +1202,29 @@ void ListView::onInteract(pressedKey key, char /*c*/, uint8_t& userState, TUIman
     }
 }
 
+// A held arrow key moves the selection by the whole run at once, wrapping like single steps do
+void ListView::onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) {
+    if (key != UP && key != DOWN) { element::onInteractRepeat(key, count, userState, tui); return; }
+    const int n = itemCount();
+    if (n == 0) return;
+    const int step = (key == DOWN ? count : -count) % n;
+    selectedIndex = ((selectedIndex + step) % n + n) % n;
+}
+
 std::string ListView::getSelectedItem() const {
-    if (selectedIndex >= 0 && selectedIndex < (int)items.size()) {
-        return items[selectedIndex];
-    }
-    return "";
+    if (selectedIndex < 0 || selectedIndex >= itemCount()) return "";
+    if (!source) return items[selectedIndex];
+    if (sourceCount == 0) return "No items";
+    const int i = selectedIndex - windowFirst;
+    if (i >= 0 && i < (int)window.size()) return window[i];
+    std::string text;
+    source->itemAt(selectedIndex, text);
+    return text;
 }
 
 void ListView::setItems(const std::vector<std::string>& newItems) {
+    source = nullptr;
+    window.clear();
     items = newItems;
     if (items.empty()) {
         items.push_back("No items");
@@ -1141,6 +1235,66 @@ void ListView::setItems(const std::vector<std::string>& newItems) {
     }
     // Reset scroll
     scrollOffset = 0;
+    lastScrollOffset = -1; // new content: nothing on screen to shift
+    invalidate();
+}
+
+void ListView::setSource(ListDataSource* src) {
+    source = src;
+    reload();
+}
+
+void ListView::reload() {
+    sourceCount = source ? std::max(0, source->count()) : 0;
+    window.clear();
+    windowFirst = 0;
+    // Same as setItems
+    if (selectedIndex >= itemCount()) {
+        selectedIndex = std::max(0, itemCount() - 1);
+    }
+    scrollOffset = 0;
+    lastScrollOffset = -1;
+    invalidate();
+}
+
+int ListView::itemCount() const {
+    if (!source) return (int)items.size();
+    return std::max(1, sourceCount);
+}
+
+const std::string& ListView::rowText(int i) {
+    static const std::string noItems = "No items";
+    if (!source) return items[i];
+    if (sourceCount == 0) return noItems;
+    if (i < windowFirst || i >= windowFirst + (int)window.size()) materialize(i, 1);
+    return window[i - windowFirst];
+}
+
+void ListView::materialize(int first, int n) {
+    const int kMargin = 16; // rows kept above and below, so scrolling a line rarely reaches the source
+    if (!source || sourceCount == 0) return;
+    const int lo = std::max(0, first), hi = std::min(sourceCount, first + n);
+    const int windowEnd = windowFirst + (int)window.size();
+    if (lo >= windowFirst && hi <= windowEnd) return;
+
+    // Rows already in window are moved over, the rest are fetched
+    const int from = std::max(0, lo - kMargin), to = std::min(sourceCount, hi + kMargin);
+    const int keepLo = std::max(from, windowFirst), keepHi = std::max(keepLo, std::min(to, windowEnd));
+    windowSpare.resize(to - from);
+    auto fetch = [&](int a, int b) {
+        if (a >= b) return;
+        source->prefetch(a, b - a);
+        for (int i = a; i < b; ++i) source->itemAt(i, windowSpare[i - from]);
+    };
+    if (keepLo == keepHi) {
+        fetch(from, to);
+    } else {
+        fetch(from, keepLo);
+        for (int i = keepLo; i < keepHi; ++i) windowSpare[i - from].swap(window[i - windowFirst]);
+        fetch(keepHi, to);
+    }
+    window.swap(windowSpare);
+    windowFirst = from;
 }
 
 // --- RichListView Implementation ---
@@ -1204,6 +1358,14 @@ void RichListView::render(TUImanager& tui) {
     if (scrollOffset > maxScroll) scrollOffset = maxScroll;
     if (scrollOffset < 0) scrollOffset = 0;
     
+    // Whole items move by itemHeight rows per step; only full-height items are shifted
+    rect itemArea{renderPos.x + 1, renderPos.y + 1, contentWidth - scrollbarWidth, std::min(visibleItems * itemHeight, contentHeight)};
+    if (lastScrollOffset >= 0 && scrollOffset != lastScrollOffset && itemArea == lastItemArea) {
+        tui.hintScroll(itemArea, (scrollOffset - lastScrollOffset) * itemHeight);
+    }
+    lastScrollOffset = scrollOffset;
+    lastItemArea = itemArea;
+    
     // Draw items
     int currentY = renderPos.y + 1;
     for (int i = 0; i < visibleItems && (scrollOffset + i) < (int)items.size(); ++i) {
@@ -1323,6 +1485,15 @@ void RichListView::onInteract(pressedKey key, char /*c*/, uint8_t& userState, TU
     }
 }
 
+// A held arrow key moves the selection by the whole run at once, wrapping like single steps do
+void RichListView::onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) {
+    if (key != UP && key != DOWN) { element::onInteractRepeat(key, count, userState, tui); return; }
+    const int n = (int)items.size();
+    if (n == 0) return;
+    const int step = (key == DOWN ? count : -count) % n;
+    selectedIndex = ((selectedIndex + step) % n + n) % n;
+}
+
 const RichListItem* RichListView::getSelectedItem() const {
     if (selectedIndex >= 0 && selectedIndex < (int)items.size()) {
         return &items[selectedIndex];
@@ -1341,12 +1512,15 @@ void RichListView::setItems(const std::vector<RichListItem>& newItems) {
     }
     // Reset scroll
     scrollOffset = 0;
+    lastScrollOffset = -1; // new content: nothing on screen to shift
+    invalidate();
 }
 
 // ==================== NOTIFICATION MANAGER ====================
 
 void NotificationManager::push(const std::string& message, NotificationType type, int durationMs) {
     notifications.emplace_back(message, type, durationMs);
+    changed = true;
     // Limit to maxNotifications
     while ((int)notifications.size() > maxNotifications) {
         notifications.erase(notifications.begin());
@@ -1361,20 +1535,28 @@ bool NotificationManager::update(TUImanager& tui) {
             [](const Notification& n) { return n.isExpired(); }),
         notifications.end()
     );
-    bool changed = notifications.size() != oldSize;
-    if (changed) {
+    bool removed = notifications.size() != oldSize;
+    if (removed) {
         // Mark the notification area as dirty so it gets redrawn
         clearArea(tui);
     }
-    return changed;
+    return removed;
 }
 
-void NotificationManager::clearArea(TUImanager& tui) {
-    if (lastRenderedHeight > 0) {
-        int startX = tui.cols - notificationWidth - 2;
-        int startY = 1;
-        tui.markDirty(startX, startY, notificationWidth + 2, lastRenderedHeight);
+int NotificationManager::msUntilNextExpiry() const {
+    int next = -1;
+    auto now = std::chrono::steady_clock::now();
+    for (const Notification& n : notifications) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - n.created).count();
+        int left = static_cast<int>(std::max<long long>(0, n.durationMs - elapsed));
+        if (next < 0 || left < next) next = left;
     }
+    return next;
+}
+
+void NotificationManager::clearArea(TUImanager& tui) {
+    tui.hideSurface(layer);
+    changed = true;
 }
 
 color NotificationManager::getBackgroundColor(NotificationType type) const {
@@ -1399,27 +1581,34 @@ color NotificationManager::getForegroundColor(NotificationType type) const {
 
 void NotificationManager::render(TUImanager& tui) {
     if (notifications.empty()) {
-        lastRenderedHeight = 0;
+        tui.hideSurface(layer);
         return;
     }
     
-    // Save and set high z-index for notifications (above modals)
-    int prevZ = tui.getCurrentZ();
-    tui.setCurrentZ(200);
-    
     // Render from top-right corner, stacking downward
     int startX = tui.cols - notificationWidth - 2;
     int startY = 1;
+    int contentWidth = notificationWidth - 4;
+    auto boxHeightOf = [&](const Notification& notif) {
+        // Calculate height based on message length (wrap text)
+        int lines = 1 + (int)notif.message.size() / contentWidth;
+        return std::max(3, lines + 2);
+    };
+    int stackHeight = -1; // no gap after the last box
+    for (const auto& notif : notifications) stackHeight += boxHeightOf(notif) + 1;
+    
+    // The stack has its own surface above the modals; it is only drawn again when it changed
+    const rect area{startX, startY, notificationWidth, stackHeight};
+    if (!changed && layer.visible() && area == layer.area()) return;
+    changed = false;
+    // The gaps between boxes stay transparent
+    if (!tui.beginSurface(layer, area, 200)) tui.clearSurface(layer);
     
     int yOffset = 0;
     for (const auto& notif : notifications) {
         color bg = getBackgroundColor(notif.type);
         color fg = getForegroundColor(notif.type);
-        
-        // Calculate height based on message length (wrap text)
-        int contentWidth = notificationWidth - 4;
-        int lines = 1 + (int)notif.message.size() / contentWidth;
-        int boxHeight = std::max(3, lines + 2);
+        int boxHeight = boxHeightOf(notif);
         
         int x = startX;
         int y = startY + yOffset;
@@ -1456,8 +1645,5 @@ void NotificationManager::render(TUImanager& tui) {
         yOffset += boxHeight + 1;
     }
     
-    // Track how much space we used for clearing later
-    lastRenderedHeight = yOffset;
-    
-    tui.setCurrentZ(prevZ);
+    tui.endSurface();
 }
\ No newline at end of file
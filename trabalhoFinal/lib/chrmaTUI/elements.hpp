@@ -35,9 +35,13 @@ public:
     InputBar(const std::string& lbl, point pos, int w, int h);
         // Use base element::setStyle for styling
 
+    // Replace the text and schedule a redraw
+    void setText(const std::string& t);
+
     void render(TUImanager& tui) override;
     void onHover(bool isHovered) override;
     void onInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) override;
+    void onPaste(const char* text, size_t len, uint8_t& userState, TUImanager& tui) override;
     bool capturesInput() override { return true; }
 };
 
@@ -91,6 +95,9 @@ public:
     bool capturesInput() override { return true; }
     
     std::string getSelectedOption() const;
+
+private:
+    surface popup; // the open list, stacked just above the container
 };
 
 class Text : public element {
@@ -162,19 +169,39 @@ public:
         isHovered = false;
         lastBlinkTime = std::chrono::steady_clock::now();
     }
+    ~MultiLineInput() override { stopBlink(); }
 
     void render(TUImanager& tui) override;
     void onHover(bool hovered) override { isHovered = hovered; }
     void onInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) override;
+    void onPaste(const char* text, size_t len, uint8_t& userState, TUImanager& tui) override;
     bool capturesInput() override { return true; }
 
 private:
+    // Repeating timer that toggles the caret while captured (-1 when not running)
+    int blinkTimer = -1;
+    TUImanager* blinkTui = nullptr;
+    void startBlink(TUImanager& tui);
+    void stopBlink();
+
     struct Wrapped {
         std::vector<std::string> lines;   // visible lines without newlines
         std::vector<int> starts;          // starting text index for each wrapped line
     };
+    // Last result of wrapForBox and what it was computed from
+    struct WrapCache {
+        std::string text;
+        int w = -1, innerH = -1;
+        int contentWidth = 0;
+        Wrapped wrapped;
+    };
+    mutable WrapCache wrapCache;
 
     Wrapped wrap(const std::string& t, int maxWidth, TUImanager& tui) const;
+    // Wrap text for a box w columns wide with innerH content rows, narrowed by a column for the
+    // scrollbar when the lines do not fit. Reused until text or the box changes, so a captured
+    // (blinking) input does not rewrap every frame.
+    const Wrapped& wrapForBox(int w, int innerH, int& contentWidth, TUImanager& tui) const;
     std::pair<int,int> caretWrappedPos(const Wrapped& w) const; // (lineIdx, col)
 };
 
@@ -193,6 +220,18 @@ public:
     void onInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) override;
 };
 
+// Rows for a ListView that does not hold them. The list asks for the visible rows and a few around
+// them as it scrolls, so opening a million-row list costs about what one page does.
+class ListDataSource {
+public:
+    virtual ~ListDataSource() = default;
+    virtual int count() = 0;
+    // Write row i (0 <= i < count()) into out, replacing its contents
+    virtual void itemAt(int i, std::string& out) = 0;
+    // Rows [first, first + n) are about to be asked for, e.g. to load them with one query
+    virtual void prefetch(int /*first*/, int /*n*/) {}
+};
+
 // ListView: scrollable single-select list with keyboard navigation.
 // Similar to DropdownMenu but always expanded and more suitable for data display.
 class ListView : public element {
@@ -208,6 +247,7 @@ public:
     void render(TUImanager& tui) override;
     void onHover(bool hovered) override;
     void onInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) override;
+    void onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) override;
     bool capturesInput() override { return true; }
     
     std::string getSelectedItem() const;
@@ -215,6 +255,22 @@ public:
     
     // Update items dynamically (useful for search/filter)
     void setItems(const std::vector<std::string>& newItems);
+    // Take the rows from src instead of items (nullptr or setItems go back to items). Only the
+    // visible rows and a small margin around them are kept; src must outlive the list.
+    void setSource(ListDataSource* src);
+    // The source's rows changed: re-read its count and drop the rows already fetched
+    void reload();
+
+private:
+    int lastScrollOffset = -1; // scrollOffset and item rows of the last render, for TUImanager::hintScroll
+    rect lastItemArea;
+    ListDataSource* source = nullptr;
+    int sourceCount = 0;  // source->count() as of setSource/reload
+    int windowFirst = 0;  // window[i] is row windowFirst + i of the source
+    std::vector<std::string> window, windowSpare;
+    int itemCount() const; // rows shown, at least 1 ("No items")
+    const std::string& rowText(int i); // items[i], or row i of the source
+    void materialize(int first, int n); // have rows [first, first + n) and the margin around them in window
 };
 
 // RichListItem: multi-line data with per-item theming
@@ -243,6 +299,7 @@ public:
     void render(TUImanager& tui) override;
     void onHover(bool hovered) override;
     void onInteract(pressedKey key, char c, uint8_t& userState, TUImanager& tui) override;
+    void onInteractRepeat(pressedKey key, int count, uint8_t& userState, TUImanager& tui) override;
     bool capturesInput() override { return true; }
     
     int getSelectedIndex() const { return selectedIndex; }
@@ -250,6 +307,10 @@ public:
     
     // Update items dynamically
     void setItems(const std::vector<RichListItem>& newItems);
+
+private:
+    int lastScrollOffset = -1; // scrollOffset and item rows of the last render, for TUImanager::hintScroll
+    rect lastItemArea;
 };
 
 // ==================== NOTIFICATION SYSTEM ====================
@@ -289,8 +350,10 @@ public:
     void render(TUImanager& tui);
     bool update(TUImanager& tui); // Remove expired notifications, marks area dirty if any were removed
     bool empty() const { return notifications.empty(); }
+    // Milliseconds until the oldest notification expires, -1 when there are none
+    int msUntilNextExpiry() const;
     
-    // Clear the notification display area (marks it dirty for redraw)
+    // Take the stack off the screen until the next render() draws it again
     void clearArea(TUImanager& tui);
     
     int maxNotifications = 5;  // Max visible at once
@@ -298,7 +361,8 @@ public:
     
 private:
     std::vector<Notification> notifications;
-    int lastRenderedHeight = 0; // Track how much vertical space was used
+    bool changed = true;        // the stack has to be drawn again
+    surface layer;
     
     color getBackgroundColor(NotificationType type) const;
     color getForegroundColor(NotificationType type) const;
@@ -0,0 +1,137 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+// epoll user data for the fds the manager owns; application fds use the fd itself (>= 0)
+const int64_t kStdinTag = -1; // the backend's input fd
+const int64_t kTimerTag = -2;
+const int64_t kResizeTag = -3;
+const int64_t kOutputTag = -4; // the backend's output fd, only while a frame is queued
+
+void epollAdd(int epfd, int fd, int64_t tag) {
+    if (epfd < 0 || fd < 0) return;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = static_cast<uint64_t>(tag);
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev); // fails for regular files (stdin redirected); harmless
+}
+}
+
+void TUImanager::initEventLoop() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    epollAdd(epollFd, term->inputFd(), kStdinTag);
+    epollAdd(epollFd, timerFd, kTimerTag);
+    epollAdd(epollFd, term->resizeFd(), kResizeTag);
+}
+
+void TUImanager::closeEventLoop() {
+    if (timerFd >= 0) close(timerFd);
+    if (epollFd >= 0) close(epollFd);
+    timerFd = epollFd = -1;
+}
+
+void TUImanager::armTimerFd() {
+    if (timerFd < 0) return;
+    itimerspec spec{};
+    if (!timers.empty()) {
+        auto earliest = std::min_element(timers.begin(), timers.end(),
+                                         [](const timerEntry& a, const timerEntry& b) { return a.due < b.due; })->due;
+        // steady_clock is CLOCK_MONOTONIC, so its epoch count is a valid absolute timerfd deadline
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(earliest.time_since_epoch()).count();
+        if (ns <= 0) ns = 1; // 0 would disarm
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+int TUImanager::addTimer(int delayMs, std::function<void(TUImanager&)> fn, int repeatMs) {
+    const int id = nextTimerId++;
+    timers.push_back({id, std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, delayMs)), repeatMs, std::move(fn)});
+    armTimerFd();
+    return id;
+}
+
+void TUImanager::cancelTimer(int id) {
+    auto it = std::find_if(timers.begin(), timers.end(), [id](const timerEntry& t) { return t.id == id; });
+    if (it == timers.end()) return;
+    timers.erase(it);
+    armTimerFd();
+}
+
+void TUImanager::runDueTimers() {
+    uint64_t expirations;
+    while (read(timerFd, &expirations, sizeof(expirations)) > 0) {}
+    const auto now = std::chrono::steady_clock::now();
+    // Collect first: callbacks may add or cancel timers
+    std::vector<timerEntry> due;
+    for (size_t i = 0; i < timers.size();) {
+        if (timers[i].due > now) { ++i; continue; }
+        due.push_back(timers[i]);
+        if (timers[i].repeatMs > 0) {
+            timers[i].due = now + std::chrono::milliseconds(timers[i].repeatMs);
+            ++i;
+        } else {
+            timers.erase(timers.begin() + i);
+        }
+    }
+    armTimerFd();
+    for (timerEntry& t : due) t.fn(*this);
+}
+
+void TUImanager::watchOutput(bool on) {
+    if (on == watchingOutput || epollFd < 0) return;
+    epoll_event ev{};
+    ev.events = EPOLLOUT;
+    ev.data.u64 = static_cast<uint64_t>(kOutputTag);
+    // The output may be the same tty as stdin; epoll keys on the fd number, so both can be registered
+    const int outFd = term->outputFd();
+    if (on) watchingOutput = outFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, outFd, &ev) == 0;
+    else { if (outFd >= 0) epoll_ctl(epollFd, EPOLL_CTL_DEL, outFd, nullptr); watchingOutput = false; }
+}
+
+void TUImanager::watchFd(int fd, std::function<void(TUImanager&)> onReadable) {
+    unwatchFd(fd);
+    watches.push_back({fd, std::move(onReadable)});
+    epollAdd(epollFd, fd, fd);
+}
+
+void TUImanager::unwatchFd(int fd) {
+    auto it = std::find_if(watches.begin(), watches.end(), [fd](const watchEntry& w) { return w.fd == fd; });
+    if (it == watches.end()) return;
+    watches.erase(it);
+    if (epollFd >= 0) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+bool TUImanager::waitEvents(int timeoutMs) {
+    if (epollFd < 0) return false;
+    epoll_event events[16];
+    int n = epoll_wait(epollFd, events, 16, timeoutMs);
+    if (n < 0) return false; // EINTR: the caller's loop comes around again
+    bool input = false;
+    for (int i = 0; i < n; ++i) {
+        const int64_t tag = static_cast<int64_t>(events[i].data.u64);
+        if (tag == kStdinTag) {
+            input = true;
+        } else if (tag == kTimerTag) {
+            const auto start = std::chrono::steady_clock::now();
+            runDueTimers();
+            profileCur.callbacksUs += usSince(start);
+        } else if (tag == kResizeTag) {
+            checkResize();
+        } else if (tag == kOutputTag) {
+            const auto start = std::chrono::steady_clock::now();
+            flushOutput();
+            profileCur.writeUs += usSince(start);
+        } else {
+            auto it = std::find_if(watches.begin(), watches.end(), [tag](const watchEntry& w) { return w.fd == tag; });
+            if (it != watches.end()) {
+                const auto start = std::chrono::steady_clock::now();
+                auto onReadable = it->onReadable; // the callback may unwatch itself
+                onReadable(*this);
+                profileCur.callbacksUs += usSince(start);
+            }
+        }
+    }
+    return input;
+}
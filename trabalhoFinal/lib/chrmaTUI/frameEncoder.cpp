@@ -0,0 +1,383 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+// Decimal spellings of 0..255, so SGR color components and most cursor
+// coordinates are copied instead of formatted.
+struct decimalEntry {
+    char digits[3];
+    uint8_t len;
+};
+
+struct decimalTable {
+    decimalEntry entries[256];
+    decimalTable() {
+        for (int v = 0; v < 256; ++v) {
+            decimalEntry& e = entries[v];
+            if (v >= 100) {
+                e.digits[0] = static_cast<char>('0' + v / 100);
+                e.digits[1] = static_cast<char>('0' + (v / 10) % 10);
+                e.digits[2] = static_cast<char>('0' + v % 10);
+                e.len = 3;
+            } else if (v >= 10) {
+                e.digits[0] = static_cast<char>('0' + v / 10);
+                e.digits[1] = static_cast<char>('0' + v % 10);
+                e.len = 2;
+            } else {
+                e.digits[0] = static_cast<char>('0' + v);
+                e.len = 1;
+            }
+        }
+    }
+};
+
+const decimalTable kDecimal;
+}
+
+void outputArena::grow(size_t n) {
+    size_t need = len + n;
+    size_t cap = std::max<size_t>(buf.size() * 2, 4096);
+    while (cap < need) cap *= 2;
+    buf.resize(cap);
+}
+
+void outputArena::putUInt(unsigned v) {
+    if (v < 256) {
+        const decimalEntry& e = kDecimal.entries[v];
+        put(e.digits, e.len);
+        return;
+    }
+    char tmp[10];
+    int n = 0;
+    while (v > 0) { tmp[n++] = static_cast<char>('0' + v % 10); v /= 10; }
+    if (len + n > buf.size()) grow(n);
+    while (n > 0) buf[len++] = tmp[--n];
+}
+
+namespace {
+inline int decimalDigits(unsigned v) { return v < 10 ? 1 : v < 100 ? 2 : v < 1000 ? 3 : v < 10000 ? 4 : 5; }
+// Bytes of "CSI n X", where n is omitted when it is 1
+inline int csiCost(unsigned n) { return n == 1 ? 3 : 3 + decimalDigits(n); }
+inline bool isBlank(const cell& c) { return c.glyphLen == 1 && c.glyph[0] == ' '; }
+}
+
+void frameEncoder::beginBand() {
+    out.clear();
+    if (opts.depth != sgrDepth) {
+        sgrCache.clear();
+        sgrDepth = opts.depth;
+    }
+    forgetColors();
+    forgetCursor();
+}
+
+void frameEncoder::beginFrame() {
+    beginBand();
+    // Hold the terminal's redraw until the whole frame is in (DEC synchronized output)
+    if (opts.syncUpdates) out.put("\x1b[?2026h", 8);
+    // Disable line wrap to avoid auto-wrapping the last column into the next line, too stupid to fix this the right way
+    out.put("\x1b[?7l", 5);
+}
+
+void frameEncoder::endFrame() {
+    // Reset attributes and restore wrap mode
+    out.put("\x1b[0m\x1b[?7h", 9);
+    if (opts.syncUpdates) out.put("\x1b[?2026l", 8);
+}
+
+void frameEncoder::emitCSI(unsigned n, char final) {
+    out.put("\x1b[", 2);
+    if (n != 1) out.putUInt(n);
+    out.put(final);
+}
+
+// Cost in bytes of the cheapest way from the tracked cursor to (x, y)
+int frameEncoder::moveCost(int x, int y) const {
+    int cup = 3 + decimalDigits(static_cast<unsigned>(y + 1)) + (x > 0 ? 1 + decimalDigits(static_cast<unsigned>(x + 1)) : 0);
+    if (!opts.relativeMoves || curX < 0) return cup;
+    int dy = y - curY, dx = x - curX;
+    int vert = dy == 0 ? 0 : dy > 0 ? std::min(dy, csiCost(dy)) : csiCost(-dy);
+    int horiz = dx == 0 ? 0 : dx > 0 ? csiCost(dx) : std::min(csiCost(-dx), 1 + (x > 0 ? csiCost(x) : 0));
+    return std::min(cup, vert + horiz);
+}
+
+void frameEncoder::moveTo(int x, int y) {
+    if (x == curX && y == curY) return;
+    int cup = 3 + decimalDigits(static_cast<unsigned>(y + 1)) + (x > 0 ? 1 + decimalDigits(static_cast<unsigned>(x + 1)) : 0);
+    if (!opts.relativeMoves || curX < 0 || moveCost(x, y) >= cup) {
+        out.put("\x1b[", 2);
+        out.putUInt(static_cast<unsigned>(y + 1));
+        if (x > 0) { out.put(';'); out.putUInt(static_cast<unsigned>(x + 1)); }
+        out.put('H');
+    } else {
+        int dy = y - curY, dx = x - curX;
+        // Vertical first: LF/CUD/CUU keep the column (output post-processing is off in raw mode)
+        if (dy > 0) {
+            if (dy <= csiCost(dy)) { for (int i = 0; i < dy; ++i) out.put('\n'); }
+            else emitCSI(static_cast<unsigned>(dy), 'B');
+        } else if (dy < 0) {
+            emitCSI(static_cast<unsigned>(-dy), 'A');
+        }
+        if (dx > 0) {
+            emitCSI(static_cast<unsigned>(dx), 'C');
+        } else if (dx < 0) {
+            if (1 + (x > 0 ? csiCost(static_cast<unsigned>(x)) : 0) < csiCost(static_cast<unsigned>(-dx))) {
+                out.put('\r');
+                if (x > 0) emitCSI(static_cast<unsigned>(x), 'C');
+            } else {
+                emitCSI(static_cast<unsigned>(-dx), 'D');
+            }
+        }
+    }
+    curX = x;
+    curY = y;
+}
+
+namespace {
+// xterm's default 16-color palette
+const uint8_t kAnsi16[16][3] = {
+    {0, 0, 0},       {205, 0, 0},     {0, 205, 0},     {205, 205, 0},
+    {0, 0, 238},     {205, 0, 205},   {0, 205, 205},   {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0},     {0, 255, 0},     {255, 255, 0},
+    {92, 92, 255},   {255, 0, 255},   {0, 255, 255},   {255, 255, 255},
+};
+const uint8_t kCubeLevels[6] = {0, 95, 135, 175, 215, 255};
+
+// Luma-ish weights keep greens from collapsing into grays
+inline int colorDistance(int r, int g, int b, const uint8_t* p) {
+    int dr = r - p[0], dg = g - p[1], db = b - p[2];
+    return 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+}
+
+// Nearest palette index for every 5-bit-per-channel color, built once on first use
+struct paletteTables {
+    uint8_t to256[1 << 15];
+    uint8_t to16[1 << 15];
+    paletteTables() {
+        uint8_t gray[24][3];
+        for (int i = 0; i < 24; ++i) gray[i][0] = gray[i][1] = gray[i][2] = static_cast<uint8_t>(8 + 10 * i);
+        for (int idx = 0; idx < (1 << 15); ++idx) {
+            int r = ((idx >> 10) & 31) << 3 | 4, g = ((idx >> 5) & 31) << 3 | 4, b = (idx & 31) << 3 | 4;
+
+            // The weighted distance is separable, so the nearest cube point is the nearest level per channel
+            uint8_t cube[3];
+            int ci[3];
+            const int ch[3] = {r, g, b};
+            for (int k = 0; k < 3; ++k) {
+                int best = 0;
+                for (int l = 1; l < 6; ++l) {
+                    if (std::abs(ch[k] - kCubeLevels[l]) < std::abs(ch[k] - kCubeLevels[best])) best = l;
+                }
+                ci[k] = best;
+                cube[k] = kCubeLevels[best];
+            }
+            int best256 = 16 + 36 * ci[0] + 6 * ci[1] + ci[2];
+            int bestDist = colorDistance(r, g, b, cube);
+            for (int i = 0; i < 24; ++i) {
+                int d = colorDistance(r, g, b, gray[i]);
+                if (d < bestDist) { bestDist = d; best256 = 232 + i; }
+            }
+            to256[idx] = static_cast<uint8_t>(best256);
+
+            int best16 = 0;
+            bestDist = colorDistance(r, g, b, kAnsi16[0]);
+            for (int i = 1; i < 16; ++i) {
+                int d = colorDistance(r, g, b, kAnsi16[i]);
+                if (d < bestDist) { bestDist = d; best16 = i; }
+            }
+            to16[idx] = static_cast<uint8_t>(best16);
+        }
+    }
+};
+
+const paletteTables& palettes() {
+    static const paletteTables tables;
+    return tables;
+}
+
+inline unsigned paletteSlot(uint32_t rgb) {
+    return ((rgb >> 9) & 0x7C00) | ((rgb >> 6) & 0x03E0) | ((rgb >> 3) & 0x001F);
+}
+}
+
+uint32_t frameEncoder::colorKey(uint32_t rgb) const {
+    switch (opts.depth) {
+        case depth256: return 0x1000000u | palettes().to256[paletteSlot(rgb)];
+        case depth16: return 0x1000000u | palettes().to16[paletteSlot(rgb)];
+        default: return rgb;
+    }
+}
+
+uint8_t frameEncoder::formatColor(uint32_t key, bool background, char* dst) const {
+    uint8_t n = 0;
+    auto put = [&](const char* p, uint8_t len) { std::memcpy(dst + n, p, len); n = static_cast<uint8_t>(n + len); };
+    auto putUInt = [&](unsigned v) { const decimalEntry& e = kDecimal.entries[v]; put(e.digits, e.len); };
+    put("\x1b[", 2);
+    if (opts.depth == depthTrueColor) {
+        put(background ? "48;2;" : "38;2;", 5);
+        putUInt((key >> 16) & 0xFF); put(";", 1);
+        putUInt((key >> 8) & 0xFF); put(";", 1);
+        putUInt(key & 0xFF);
+    } else if (opts.depth == depth256) {
+        put(background ? "48;5;" : "38;5;", 5);
+        putUInt(key & 0xFF);
+    } else {
+        unsigned idx = key & 0x0F;
+        putUInt((idx < 8 ? 30 : 82) + idx + (background ? 10 : 0));
+    }
+    put("m", 1);
+    return n;
+}
+
+const frameEncoder::sgrEntry& frameEncoder::sgr(uint16_t style) {
+    if (style >= sgrCache.size()) sgrCache.resize(std::max<size_t>(style + 1, styles->size()), sgrEntry{});
+    sgrEntry& e = sgrCache[style];
+    if (e.fgLen == 0) {
+        e.fgKey = colorKey(styles->fg(style));
+        e.bgKey = colorKey(styles->bg(style));
+        e.fgLen = formatColor(e.fgKey, false, e.fgSgr);
+        e.bgLen = formatColor(e.bgKey, true, e.bgSgr);
+    }
+    return e;
+}
+
+void frameEncoder::setStyle(uint16_t style) {
+    if (style == curStyle) return;
+    const sgrEntry& e = sgr(style);
+    if (e.fgKey != curFg) {
+        curFg = e.fgKey;
+        out.put(e.fgSgr, e.fgLen);
+    }
+    if (e.bgKey != curBg) {
+        curBg = e.bgKey;
+        out.put(e.bgSgr, e.bgLen);
+    }
+    curStyle = style;
+}
+
+void frameEncoder::setBackground(uint16_t style) {
+    if (style == curStyle) return;
+    const sgrEntry& e = sgr(style);
+    if (e.bgKey != curBg) {
+        curBg = e.bgKey;
+        out.put(e.bgSgr, e.bgLen);
+    }
+    curStyle = e.fgKey == curFg ? style : styleUnknown;
+}
+
+void frameEncoder::glyph(const cell& c) {
+    out.put(c.glyph, c.glyphLen);
+    curX += (c.flags & cellWide) ? 2 : 1;
+    // Autowrap is off, so a glyph in the last column leaves the cursor somewhere we do not track
+    if (curX >= cols) forgetCursor();
+}
+
+size_t frameEncoder::encodeRow(const cell* back, const cell* front, int y) {
+    size_t emitted = 0;
+    if (!opts.carryColors) forgetColors();
+    int x = 0;
+    while (x < cols) {
+        // Skip cells the terminal already shows
+        while (x < cols && cellVisiblyEqual(back[x], front[x])) ++x;
+        if (x >= cols) break;
+        const int changed = x;
+        // A changed placeholder means its wide lead glyph has to be rewritten as well, and
+        // writing over the tail of a wide glyph on the terminal breaks it, so back up to the lead.
+        while (x > 0 && (back[x].glyphLen == 0 || front[x].glyphLen == 0)) --x;
+        if (back[x].glyphLen == 0) { x = changed + 1; continue; } // orphan placeholder: nothing to print
+
+        // Emit the changed span
+        while (x < cols) {
+            const cell& c = back[x];
+            if (c.glyphLen == 0) { ++x; continue; } // covered by the wide glyph before it (or orphaned)
+            if (x > changed && cellVisiblyEqual(c, front[x])) {
+                // Unchanged cell: keep printing through the gap only if that is cheaper than a
+                // cursor move to the next change and needs no SGR or wide-glyph handling.
+                if (!opts.relativeMoves) break;
+                int next = x, bridge = 0;
+                bool bridgeable = true;
+                while (next < cols && cellVisiblyEqual(back[next], front[next])) {
+                    const cell& b = back[next];
+                    if (b.glyphLen == 0 || (b.flags & cellWide)) { bridgeable = false; break; }
+                    if (b.style != curStyle) {
+                        const sgrEntry& e = sgr(b.style);
+                        if (e.bgKey != curBg || (e.fgKey != curFg && !(opts.eraseRuns && isBlank(b)))) { bridgeable = false; break; }
+                    }
+                    bridge += b.glyphLen;
+                    if (bridge > 16) { bridgeable = false; break; } // longer than any cursor move
+                    ++next;
+                }
+                if (!bridgeable || next >= cols || bridge >= moveCost(next, y)) break;
+            }
+
+            if (opts.eraseRuns && isBlank(c)) {
+                int run = 1;
+                const uint32_t bg = styles->bg(c.style);
+                while (x + run < cols && isBlank(back[x + run]) && styles->bg(back[x + run].style) == bg) ++run;
+                if (x + run == cols && run > 3) {
+                    // Blank to the end of the row: EL paints the rest with the current background
+                    moveTo(x, y);
+                    setBackground(c.style);
+                    out.put("\x1b[K", 3);
+                    emitted += static_cast<size_t>(run);
+                    x = cols;
+                    break;
+                }
+                // ECH leaves the cursor in place, so it pays off when the run is longer than ECH plus
+                // the move needed to skip over it
+                if (run > csiCost(static_cast<unsigned>(run)) * 2) {
+                    moveTo(x, y);
+                    setBackground(c.style);
+                    emitCSI(static_cast<unsigned>(run), 'X');
+                    emitted += static_cast<size_t>(run);
+                    x += run;
+                    continue;
+                }
+            }
+
+            moveTo(x, y);
+            if (opts.eraseRuns && isBlank(c)) setBackground(c.style);
+            else setStyle(c.style);
+            glyph(c);
+            ++emitted;
+            ++x;
+
+            // Identical cells after it (changed or not, rewriting them is harmless) can be repeated
+            // with REP, which refers to the glyph just printed
+            if (opts.repeatRuns == repeatAny ? !(c.flags & cellWide) : opts.repeatRuns == repeatAscii && c.glyphLen == 1) {
+                int run = 0;
+                while (x + run < cols && back[x + run].glyphLen == c.glyphLen && cellVisiblyEqual(back[x + run], c)) ++run;
+                if (run > 0 && csiCost(static_cast<unsigned>(run)) < run * c.glyphLen) {
+                    emitCSI(static_cast<unsigned>(run), 'b');
+                    emitted += static_cast<size_t>(run);
+                    x += run;
+                    curX += run;
+                    if (curX >= cols) forgetCursor();
+                }
+            }
+        }
+        // Placeholders right after the span are covered by the wide glyph just written
+        while (x < cols && back[x].glyphLen == 0) ++x;
+        x = std::max(x, changed + 1);
+    }
+    return emitted;
+}
+
+bool writeAll(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) return false;
+            struct pollfd pfd{fd, POLLOUT, 0}; // non-blocking fd: wait until it takes more
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+bool frameEncoder::flush(int fd) {
+    return writeAll(fd, out.data(), out.size());
+}
@@ -0,0 +1,84 @@
+#include "chrmaTUI.hpp"
+
+void frameWriter::start(terminalBackend* backend) {
+    if (running()) return;
+    term = backend;
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) return; // stays off: render() keeps writing itself
+    stopping.store(false);
+    thread = std::thread([this] { run(); });
+}
+
+void frameWriter::stop() {
+    if (!running()) return;
+    stopping.store(true);
+    const uint64_t one = 1;
+    write(wakeFd, &one, sizeof(one));
+    thread.join();
+    close(wakeFd);
+    wakeFd = -1;
+}
+
+void frameWriter::publish(outputArena& out) {
+    std::swap(out, slots[uiSlot]);
+    // The previous frame was either taken by the writer or withdrawn by retract(), so the slot
+    // coming back is free
+    uiSlot = middle.exchange(static_cast<uint8_t>(uiSlot | kFresh), std::memory_order_acq_rel) & 3;
+    const uint64_t one = 1;
+    write(wakeFd, &one, sizeof(one));
+}
+
+bool frameWriter::retract() {
+    uint8_t m = middle.load(std::memory_order_acquire);
+    // Fails if the writer takes the frame in between; then it was not dropped
+    return (m & kFresh) && middle.compare_exchange_strong(m, static_cast<uint8_t>(m & 3), std::memory_order_acq_rel);
+}
+
+void frameWriter::run() {
+    for (;;) {
+        uint64_t wakeups;
+        if (read(wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno == EINTR) continue;
+        const bool last = stopping.load(); // read first: stop() comes after the final publish()
+        uint8_t m = middle.load(std::memory_order_acquire);
+        while (m & kFresh) {
+            // CAS rather than exchange so a frame retract() withdrew meanwhile is never written
+            if (!middle.compare_exchange_weak(m, writerSlot, std::memory_order_acq_rel)) continue;
+            writerSlot = m & 3;
+            writeFrame(slots[writerSlot]);
+            m = middle.load(std::memory_order_acquire);
+        }
+        if (last) return;
+    }
+}
+
+void frameWriter::writeFrame(const outputArena& frame) {
+    const char* p = frame.data();
+    size_t left = frame.size();
+    bool stalled = false;
+    while (left > 0) {
+        queuedBytes.store(left, std::memory_order_relaxed);
+        if (left > maxQueuedBytes.load(std::memory_order_relaxed)) maxQueuedBytes.store(left, std::memory_order_relaxed);
+        ssize_t w = term->write(p, left);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) break;
+            if (!stalled) stalls.fetch_add(1, std::memory_order_relaxed);
+            stalled = true;
+            struct pollfd pfd{term->outputFd(), POLLOUT, 0};
+            if (pfd.fd < 0) break;
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (static_cast<size_t>(w) < left) partialWrites.fetch_add(1, std::memory_order_relaxed);
+        p += w;
+        left -= static_cast<size_t>(w);
+    }
+    queuedBytes.store(0, std::memory_order_relaxed);
+}
+
+void frameWriter::addStats(outputStats& stats) const {
+    stats.queuedBytes += queuedBytes.load(std::memory_order_relaxed);
+    stats.maxQueuedBytes = std::max(stats.maxQueuedBytes, maxQueuedBytes.load(std::memory_order_relaxed));
+    stats.partialWrites += partialWrites.load(std::memory_order_relaxed);
+    stats.stalls += stalls.load(std::memory_order_relaxed);
+}
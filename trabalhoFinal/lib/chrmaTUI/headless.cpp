@@ -0,0 +1,269 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+int csiParam(const std::vector<int>& p, size_t i, int fallback) {
+    return i < p.size() && p[i] > 0 ? p[i] : fallback;
+}
+
+char32_t decodeUtf8(const char* s, int len) {
+    const unsigned char b0 = static_cast<unsigned char>(s[0]);
+    if (len == 1) return b0;
+    char32_t cp = b0 & (0x7F >> len);
+    for (int i = 1; i < len; ++i) cp = (cp << 6) | (static_cast<unsigned char>(s[i]) & 0x3F);
+    return cp;
+}
+
+int utf8Length(unsigned char lead) {
+    if (lead < 0x80) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 0; // stray continuation byte
+}
+}
+
+headlessBackend::headlessBackend(int rows, int cols) : rows(std::max(1, rows)), cols(std::max(1, cols)) {
+    pipe2(inPipe, O_NONBLOCK | O_CLOEXEC);
+    pipe2(resizePipe, O_NONBLOCK | O_CLOEXEC);
+    bottom = this->rows - 1;
+    right = this->cols - 1;
+    vtCell blank{{' '}, 1, kDefaultColor, kDefaultColor};
+    screen.assign(static_cast<size_t>(this->rows) * this->cols, blank);
+    lastGlyph = blank;
+}
+
+headlessBackend::~headlessBackend() {
+    for (int fd : {inPipe[0], inPipe[1], resizePipe[0], resizePipe[1]}) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool headlessBackend::type(const std::string& bytes) {
+    ssize_t w = ::write(inPipe[1], bytes.data(), bytes.size());
+    return w == static_cast<ssize_t>(bytes.size());
+}
+
+void headlessBackend::setSize(int newRows, int newCols) {
+    newRows = std::max(1, newRows);
+    newCols = std::max(1, newCols);
+    // Like a terminal's reflow-less resize: keep the overlap, blank the rest
+    vtCell blank{{' '}, 1, kDefaultColor, kDefaultColor};
+    std::vector<vtCell> resized(static_cast<size_t>(newRows) * newCols, blank);
+    for (int y = 0; y < std::min(rows, newRows); ++y) {
+        for (int x = 0; x < std::min(cols, newCols); ++x) resized[static_cast<size_t>(y) * newCols + x] = at(x, y);
+    }
+    screen.swap(resized);
+    rows = newRows;
+    cols = newCols;
+    top = left = 0;
+    bottom = rows - 1;
+    right = cols - 1;
+    curX = std::min(curX, cols - 1);
+    curY = std::min(curY, rows - 1);
+    const char one = 1;
+    ::write(resizePipe[1], &one, 1);
+}
+
+bool headlessBackend::takeResize() {
+    char buf[64];
+    bool got = false;
+    while (::read(resizePipe[0], buf, sizeof(buf)) > 0) got = true;
+    return got;
+}
+
+ssize_t headlessBackend::write(const char* p, size_t n) {
+    ++writeCalls;
+    bytesWritten += n;
+    if (captureBytes) output.append(p, n);
+    if (decodeScreen) {
+        for (size_t i = 0; i < n; ++i) feed(p[i]);
+    }
+    return static_cast<ssize_t>(n);
+}
+
+void headlessBackend::feed(char b) {
+    switch (state) {
+        case vtGround:
+            if (utf8Need > 0) {
+                utf8[utf8Len++] = b;
+                if (utf8Len == utf8Need) { print(utf8, utf8Len); utf8Need = 0; }
+                return;
+            }
+            if (b == '\x1b') { state = vtEsc; return; }
+            if (b == '\r') { curX = marginsMode && curX >= left ? left : 0; return; }
+            if (b == '\n') {
+                if (curY == bottom) scroll(1);
+                else if (curY < rows - 1) ++curY;
+                return;
+            }
+            if (static_cast<unsigned char>(b) < 0x20) return; // other controls are never sent
+            utf8Need = utf8Length(static_cast<unsigned char>(b));
+            if (utf8Need == 0) return;
+            utf8[0] = b;
+            utf8Len = 1;
+            if (utf8Need == 1) { print(utf8, 1); utf8Need = 0; }
+            return;
+        case vtEsc:
+            if (b == '[') { state = vtCsi; params.clear(); }
+            else state = vtGround;
+            return;
+        case vtCsi:
+            if (b >= 0x20 && b <= 0x3F) { params += b; return; }
+            state = vtGround;
+            if (b >= 0x40 && b <= 0x7E) csi(b);
+            return;
+    }
+}
+
+void headlessBackend::print(const char* g, int len) {
+    const int width = std::max(1, glyphWidth(decodeUtf8(g, len)));
+    vtCell c{};
+    std::memcpy(c.glyph, g, static_cast<size_t>(len));
+    c.glyphLen = static_cast<uint8_t>(len);
+    c.fg = fg;
+    c.bg = bg;
+    lastGlyph = c;
+    if (curX + width > cols) {
+        if (!autowrap) curX = cols - width; // the last column is overwritten in place
+        else { curX = 0; if (curY == bottom) scroll(1); else if (curY < rows - 1) ++curY; }
+    }
+    screen[static_cast<size_t>(curY) * cols + curX] = c;
+    if (width == 2) {
+        vtCell tail = c;
+        tail.glyphLen = 0;
+        screen[static_cast<size_t>(curY) * cols + curX + 1] = tail;
+    }
+    // Without autowrap the cursor stays on the last column; with it, the next glyph wraps
+    curX = std::min(curX + width, autowrap ? cols : cols - 1);
+}
+
+void headlessBackend::eraseCells(int y, int x0, int x1) {
+    vtCell blank{{' '}, 1, fg, bg};
+    for (int x = std::max(0, x0); x < std::min(cols, x1); ++x) screen[static_cast<size_t>(y) * cols + x] = blank;
+}
+
+void headlessBackend::scroll(int n) {
+    const int l = marginsMode ? left : 0, r = marginsMode ? right : cols - 1;
+    const int height = bottom - top + 1;
+    n = std::max(-height, std::min(height, n));
+    if (n > 0) {
+        for (int y = top; y <= bottom - n; ++y) {
+            std::copy(&screen[static_cast<size_t>(y + n) * cols + l], &screen[static_cast<size_t>(y + n) * cols + r + 1],
+                      &screen[static_cast<size_t>(y) * cols + l]);
+        }
+        for (int y = bottom - n + 1; y <= bottom; ++y) eraseCells(y, l, r + 1);
+    } else if (n < 0) {
+        for (int y = bottom; y >= top - n; --y) {
+            std::copy(&screen[static_cast<size_t>(y + n) * cols + l], &screen[static_cast<size_t>(y + n) * cols + r + 1],
+                      &screen[static_cast<size_t>(y) * cols + l]);
+        }
+        for (int y = top; y < top - n; ++y) eraseCells(y, l, r + 1);
+    }
+}
+
+void headlessBackend::csi(char final) {
+    const bool priv = !params.empty() && params[0] == '?';
+    std::vector<int> p;
+    {
+        int v = -1;
+        for (size_t i = priv ? 1 : 0; i <= params.size(); ++i) {
+            if (i == params.size() || params[i] == ';') { p.push_back(v); v = -1; }
+            else if (params[i] >= '0' && params[i] <= '9') v = (v < 0 ? 0 : v * 10) + (params[i] - '0');
+        }
+    }
+    if (priv) {
+        if (final != 'h' && final != 'l') return;
+        const bool on = final == 'h';
+        for (int mode : p) {
+            if (mode == 7) autowrap = on;
+            else if (mode == 69) { marginsMode = on; left = 0; right = cols - 1; }
+        }
+        return;
+    }
+    const int n = csiParam(p, 0, 1);
+    switch (final) {
+        case 'H':
+            curY = std::min(rows, csiParam(p, 0, 1)) - 1;
+            curX = std::min(cols, csiParam(p, 1, 1)) - 1;
+            break;
+        case 'A': curY = std::max(curY >= top ? top : 0, curY - n); break;
+        case 'B': curY = std::min(curY <= bottom ? bottom : rows - 1, curY + n); break;
+        case 'C': curX = std::min(cols - 1, curX + n); break;
+        case 'D': curX = std::max(0, curX - n); break;
+        case 'K': {
+            const int mode = p.empty() || p[0] < 0 ? 0 : p[0];
+            if (mode == 0) eraseCells(curY, curX, cols);
+            else if (mode == 1) eraseCells(curY, 0, curX + 1);
+            else eraseCells(curY, 0, cols);
+            break;
+        }
+        case 'J': {
+            const int mode = p.empty() || p[0] < 0 ? 0 : p[0];
+            if (mode == 0) { eraseCells(curY, curX, cols); for (int y = curY + 1; y < rows; ++y) eraseCells(y, 0, cols); }
+            else if (mode == 1) { for (int y = 0; y < curY; ++y) eraseCells(y, 0, cols); eraseCells(curY, 0, curX + 1); }
+            else { for (int y = 0; y < rows; ++y) eraseCells(y, 0, cols); }
+            break;
+        }
+        case 'X': eraseCells(curY, curX, curX + n); break; // the cursor stays
+        case 'b':
+            for (int i = 0; i < n; ++i) print(lastGlyph.glyph, lastGlyph.glyphLen);
+            break;
+        case 'S': scroll(n); break;
+        case 'T': scroll(-n); break;
+        case 'r':
+            top = csiParam(p, 0, 1) - 1;
+            bottom = std::min(rows, csiParam(p, 1, rows)) - 1;
+            if (top >= bottom) { top = 0; bottom = rows - 1; }
+            curX = curY = 0; // DECSTBM homes the cursor
+            break;
+        case 's':
+            if (!marginsMode) break; // SCOSC otherwise; the encoder never saves the cursor
+            left = csiParam(p, 0, 1) - 1;
+            right = std::min(cols, csiParam(p, 1, cols)) - 1;
+            if (left >= right) { left = 0; right = cols - 1; }
+            curX = curY = 0;
+            break;
+        case 'm':
+            if (p.empty()) p.push_back(0);
+            for (size_t i = 0; i < p.size(); ++i) {
+                const int v = std::max(0, p[i]);
+                if (v == 0) { fg = bg = kDefaultColor; }
+                else if (v == 38 || v == 48) {
+                    uint32_t& target = v == 38 ? fg : bg;
+                    if (csiParam(p, i + 1, 0) == 2 && i + 4 < p.size()) {
+                        target = (static_cast<uint32_t>(std::max(0, p[i + 2])) << 16) |
+                                 (static_cast<uint32_t>(std::max(0, p[i + 3])) << 8) | static_cast<uint32_t>(std::max(0, p[i + 4]));
+                        i += 4;
+                    } else if (csiParam(p, i + 1, 0) == 5 && i + 2 < p.size()) {
+                        target = 0x1000000u | static_cast<uint32_t>(std::max(0, p[i + 2]));
+                        i += 2;
+                    }
+                }
+                else if (v >= 30 && v <= 37) fg = 0x1000000u | static_cast<uint32_t>(v - 30);
+                else if (v >= 90 && v <= 97) fg = 0x1000000u | static_cast<uint32_t>(v - 90 + 8);
+                else if (v >= 40 && v <= 47) bg = 0x1000000u | static_cast<uint32_t>(v - 40);
+                else if (v >= 100 && v <= 107) bg = 0x1000000u | static_cast<uint32_t>(v - 100 + 8);
+                else if (v == 39) fg = kDefaultColor;
+                else if (v == 49) bg = kDefaultColor;
+            }
+            break;
+    }
+}
+
+size_t headlessBackend::mismatches(const TUImanager& tui) const {
+    size_t diff = 0;
+    for (int y = 0; y < std::min(rows, tui.rows); ++y) {
+        for (int x = 0; x < std::min(cols, tui.cols); ++x) {
+            const cell& want = tui.cellAt(x, y);
+            if (want.glyphLen == 0) continue; // shown by the wide glyph before it
+            const vtCell& got = at(x, y);
+            const bool blank = want.glyphLen == 1 && want.glyph[0] == ' ';
+            if (got.glyphLen != want.glyphLen || std::memcmp(got.glyph, want.glyph, want.glyphLen) != 0 ||
+                got.bg != tui.encoder.colorKey(tui.styles.bg(want.style)) ||
+                (!blank && got.fg != tui.encoder.colorKey(tui.styles.fg(want.style)))) {
+                ++diff;
+            }
+        }
+    }
+    return diff;
+}
@@ -0,0 +1,134 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+const char kPasteEnd[] = "\x1b[201~";
+const int kPasteEndLen = 6;
+
+bool paramsAre(const char* params, int len, const char* want) {
+    return static_cast<size_t>(len) == std::strlen(want) && std::memcmp(params, want, static_cast<size_t>(len)) == 0;
+}
+}
+
+bool inputDecoder::drain(int fd) {
+    for (;;) {
+        // Read into the free space, which is at most two contiguous pieces of the ring
+        size_t got = 0, asked = 0;
+        while (head - tail < kRingSize) {
+            const size_t at = head & (kRingSize - 1);
+            const size_t room = std::min(kRingSize - (head - tail), kRingSize - at);
+            ssize_t n = read(fd, ring + at, room);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN) return false;
+                n = 0;
+            }
+            asked += room;
+            got += static_cast<size_t>(n);
+            head += static_cast<size_t>(n);
+            if (static_cast<size_t>(n) < room) break; // drained
+        }
+        decode();
+        if (got < asked || got == 0) return true; // a full ring may have left bytes in the kernel
+    }
+}
+
+void inputDecoder::decode() {
+    while (tail != head) step(ring[tail++ & (kRingSize - 1)]);
+}
+
+void inputDecoder::flushPending() {
+    if (state == stEsc) emit(ESC, 0);
+    if (midSequence()) state = stGround;
+}
+
+void inputDecoder::emit(pressedKey key, char c) {
+    // Held arrow keys repeat faster than frames go out; a run becomes one event with a count
+    const bool arrow = key == UP || key == DOWN || key == LEFT || key == RIGHT;
+    if (arrow && !events.empty() && !events.back().paste && events.back().key == key) {
+        ++events.back().count;
+        return;
+    }
+    inputEvent ev;
+    ev.key = key;
+    ev.c = c;
+    events.push_back(ev);
+}
+
+void inputDecoder::step(char b) {
+    switch (state) {
+        case stGround:
+            if (b == '\x1b') state = stEsc;
+            else emit(mapCharToKey(b), b);
+            break;
+        case stEsc:
+            if (b == '[') { state = stCsi; paramLen = 0; }
+            else if (b == 'O') state = stSs3;
+            else if (b == '\x1b') emit(ESC, 0); // ESC ESC: the first one stood alone
+            else state = stGround;              // Alt+key is not supported; dropped like before
+            break;
+        case stCsi:
+            if (b >= 0x20 && b <= 0x3F) {
+                if (paramLen < static_cast<int>(sizeof(params))) params[paramLen] = b;
+                ++paramLen; // an overlong sequence matches nothing in dispatchCsi
+            } else if (b >= 0x40 && b <= 0x7E) {
+                state = stGround;
+                dispatchCsi(b);
+            } else if (b == '\x1b') {
+                state = stEsc;
+            } else {
+                state = stGround; // a control byte cancels the sequence
+            }
+            break;
+        case stSs3:
+            state = stGround;
+            switch (b) {
+                case 'A': emit(UP, 0); break;
+                case 'B': emit(DOWN, 0); break;
+                case 'C': emit(RIGHT, 0); break;
+                case 'D': emit(LEFT, 0); break;
+                case 'M': emit(ENTER, 0); break; // keypad Enter in application mode
+            }
+            break;
+        case stPaste:
+            if (b == kPasteEnd[pasteMatch]) {
+                if (++pasteMatch < kPasteEndLen) break;
+                inputEvent ev;
+                ev.paste = true;
+                ev.pasteOffset = pasted.size();
+                ev.pasteLen = pasteBuf.size();
+                pasted += pasteBuf;
+                pasteBuf.clear();
+                events.push_back(ev);
+                pasteMatch = 0;
+                state = stGround;
+                break;
+            }
+            // Not the terminator after all: what matched so far was pasted text
+            pasteBuf.append(kPasteEnd, static_cast<size_t>(pasteMatch));
+            pasteMatch = 0;
+            if (b == kPasteEnd[0]) pasteMatch = 1;
+            else pasteBuf += b;
+            break;
+    }
+}
+
+void inputDecoder::dispatchCsi(char final) {
+    const int n = paramLen;
+    switch (final) {
+        case 'A': emit(UP, 0); return;    // modifiers (CSI 1;2A) are ignored
+        case 'B': emit(DOWN, 0); return;
+        case 'C': emit(RIGHT, 0); return;
+        case 'D': emit(LEFT, 0); return;
+        case '~':
+            if (paramsAre(params, n, "200")) { state = stPaste; pasteMatch = 0; return; }
+            // Shift+Enter: CSI 13;2~ and xterm's modifyOtherKeys CSI 27;2;13~
+            if (paramsAre(params, n, "13;2") || paramsAre(params, n, "27;2;13")) emit(SHIFT_ENTER, 0);
+            return;
+        case 'u': // CSI u (fixterms/kitty)
+            if (paramsAre(params, n, "13;2") || paramsAre(params, n, "13:2")) emit(SHIFT_ENTER, 0);
+            return;
+        case 'M':
+            if (paramsAre(params, n, "1;2")) emit(SHIFT_ENTER, 0);
+            return;
+    }
+}
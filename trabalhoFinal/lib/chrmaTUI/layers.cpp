@@ -0,0 +1,157 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+cell emptyCell() {
+    cell c{};
+    c.z = std::numeric_limits<int16_t>::min();
+    c.flags = cellEmpty;
+    return c;
+}
+}
+
+surface::~surface() {
+    if (owner) owner->forgetSurface(*this);
+}
+
+bool TUImanager::beginSurface(surface& s, const rect& area, int z, bool autoHide, surface* parent) {
+    if (!s.owner) {
+        s.owner = this;
+        surfaces.push_back(&s);
+    }
+    const bool fresh = s.cells.empty() || !(area == s.bounds);
+    const bool moved = fresh || z != s.z || parent != s.parent || !s.shown;
+    if (moved && s.shown) damageTree(s); // where it was
+    if (fresh) {
+        s.bounds = area;
+        s.cells.assign(area.empty() ? 0 : static_cast<size_t>(area.w) * area.h, emptyCell());
+    }
+    s.z = z;
+    s.parent = parent;
+    s.autoHide = autoHide;
+    s.lastPass = framePass;
+    s.shown = true;
+    if (moved) damageTree(s); // where it is now
+    targets.push_back({&s, tracking});
+    tracking = false; // an overlay does not grow the drawn bounds of what opened it
+    retarget();
+    return fresh;
+}
+
+void TUImanager::endSurface() {
+    if (targets.empty()) return;
+    tracking = targets.back().tracking;
+    targets.pop_back();
+    retarget();
+}
+
+void TUImanager::hideSurface(surface& s) {
+    if (!s.shown) return;
+    damageTree(s);
+    s.shown = false;
+}
+
+void TUImanager::clearSurface(surface& s) {
+    std::fill(s.cells.begin(), s.cells.end(), emptyCell());
+    if (s.shown) damageRect(s.bounds);
+}
+
+void TUImanager::forgetSurface(surface& s) {
+    hideSurface(s);
+    for (surface* t : surfaces) {
+        if (t->parent == &s) t->parent = nullptr;
+    }
+    surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), &s), surfaces.end());
+    targets.erase(std::remove_if(targets.begin(), targets.end(), [&](const targetEntry& t) { return t.s == &s; }), targets.end());
+    retarget();
+    s.owner = nullptr;
+}
+
+void TUImanager::retireSurfaces() {
+    for (surface* s : surfaces) {
+        if (s->autoHide && s->shown && s->lastPass != framePass) hideSurface(*s);
+    }
+}
+
+void TUImanager::retarget() {
+    const rect screen{0, 0, cols, rows};
+    targetArea = targets.empty() ? screen : targets.back().s->bounds.intersected(screen);
+}
+
+bool TUImanager::surfaceShown(const surface* s) const {
+    for (; s; s = s->parent) {
+        if (!s->shown) return false;
+    }
+    return true;
+}
+
+void TUImanager::damageRect(const rect& r) {
+    const rect d = r.intersected({0, 0, cols, rows});
+    for (int y = d.y; y < d.y + d.h; ++y) damage(y, d.x, d.x + d.w);
+}
+
+void TUImanager::damageTree(const surface& s) {
+    damageRect(s.bounds);
+    for (const surface* t : surfaces) {
+        for (const surface* p = t->parent; p; p = p->parent) {
+            if (p == &s) { damageRect(t->bounds); break; }
+        }
+    }
+}
+
+const cell& TUImanager::layerBelow(int x, int y) const {
+    const surface* target = targets.back().s;
+    const surface* best = nullptr;
+    bool above = false; // surfaces registered after the target win ties against it
+    for (const surface* s : surfaces) {
+        if (s == target) { above = true; continue; }
+        if (s->z > target->z || (s->z == target->z && above)) continue;
+        if (!surfaceShown(s) || !s->bounds.intersected({x, y, 1, 1}).w) continue;
+        if (best && (s->z < best->z)) continue; // registration order breaks ties: later is higher
+        if (s->cells[static_cast<size_t>(y - s->bounds.y) * s->bounds.w + (x - s->bounds.x)].flags & cellEmpty) continue;
+        best = s;
+    }
+    if (best) return best->cells[static_cast<size_t>(y - best->bounds.y) * best->bounds.w + (x - best->bounds.x)];
+    return baseLayer[static_cast<size_t>(y) * cols + x];
+}
+
+// Only the damaged span of each row is looked at: for every cell, the topmost shown surface that
+// has drawn there, or the base layer. screenBuffer changes (and render() emits) only where the
+// result differs from the last composite, so showing or hiding an overlay costs just the cells
+// it covered and nothing below it is drawn again.
+void TUImanager::compose() {
+    // Top first; equal z keeps the later registered surface on top. An insertion sort: there are
+    // a handful of surfaces, and std::stable_sort would allocate every frame.
+    layerScratch.clear();
+    for (auto it = surfaces.rbegin(); it != surfaces.rend(); ++it) {
+        if (!surfaceShown(*it)) continue;
+        layerScratch.push_back(*it);
+        for (size_t i = layerScratch.size() - 1; i > 0 && layerScratch[i - 1]->z < layerScratch[i]->z; --i) {
+            std::swap(layerScratch[i - 1], layerScratch[i]);
+        }
+    }
+    const size_t shown = layerScratch.size();
+    for (int y = 0; y < rows; ++y) {
+        const int lo = std::max(0, damageLo[y]), hi = std::min(cols, damageHi[y]);
+        damageLo[y] = cols;
+        damageHi[y] = 0;
+        if (lo >= hi) continue;
+        // The surfaces covering this row go after the shown ones, in the same order
+        layerScratch.resize(shown);
+        for (size_t i = 0; i < shown; ++i) {
+            const rect& b = layerScratch[i]->bounds;
+            if (y >= b.y && y < b.y + b.h && b.x < hi && b.x + b.w > lo) layerScratch.push_back(layerScratch[i]);
+        }
+        const size_t rowBase = static_cast<size_t>(y) * cols;
+        for (int x = lo; x < hi; ++x) {
+            const cell* top = &baseLayer[rowBase + x];
+            for (size_t i = shown; i < layerScratch.size(); ++i) {
+                surface* s = layerScratch[i];
+                if (x < s->bounds.x || x >= s->bounds.x + s->bounds.w) continue;
+                const cell& c = s->row(y)[x];
+                if (!(c.flags & cellEmpty)) { top = &c; break; }
+            }
+            if (std::memcmp(top, &screenBuffer[rowBase + x], sizeof(cell)) != 0) storeCell(rowBase + x, x, y, *top);
+        }
+    }
+    layerScratch.resize(shown);
+}
@@ -0,0 +1,77 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+const int kHudWidth = 38;
+const int kHudContainers = 3; // most expensive containers listed
+
+// Longest prefix of s that fits in maxBytes without splitting a UTF-8 sequence
+std::string utf8Prefix(const std::string& s, size_t maxBytes) {
+    if (s.size() <= maxBytes) return s;
+    size_t n = maxBytes;
+    while (n > 0 && (static_cast<unsigned char>(s[n]) & 0xC0) == 0x80) --n;
+    return s.substr(0, n);
+}
+}
+
+void TUImanager::closeProfile() {
+    profileCur.frameUs = usSince(profileStart);
+    profileStart = std::chrono::steady_clock::now();
+    profileCur.dirtyRows = lastFrame.rowsScanned;
+    profileCur.cellsEmitted = lastFrame.cellsEmitted;
+    profileCur.bytes = lastFrame.bytesEmitted;
+    std::swap(profileDone, profileCur);
+    // Start the next frame from zero but keep the container list's storage
+    std::vector<frameProfile::containerCost> reuse;
+    reuse.swap(profileCur.containers);
+    reuse.clear();
+    profileCur = frameProfile{};
+    profileCur.containers.swap(reuse);
+}
+
+void TUImanager::setProfilerHud(bool on) {
+    if (on == hudOn) return;
+    hudOn = on;
+    if (!on) hideSurface(hudLayer); // what was under it shows again
+    pendingChanges = true;
+}
+
+void TUImanager::drawHud() {
+    const frameProfile& p = profileDone;
+    const frameProfile::containerCost* top[kHudContainers] = {};
+    for (const frameProfile::containerCost& c : p.containers) {
+        for (int i = 0; i < kHudContainers; ++i) {
+            if (top[i] && top[i]->us >= c.us) continue;
+            for (int j = kHudContainers - 1; j > i; --j) top[j] = top[j - 1];
+            top[i] = &c;
+            break;
+        }
+    }
+
+    char lines[12][64];
+    int n = 0;
+    const double workUs = p.inputDecodeUs + p.inputHandlersUs + p.callbacksUs + p.layoutUs + p.drawUs + p.endOfFrameUs +
+                          p.composeUs + p.diffUs + p.encodeUs + p.writeUs;
+    std::snprintf(lines[n++], 64, " frame %7.2f ms of %7.2f ms%s", workUs / 1000, p.frameUs / 1000, p.skipped ? " skip" : "");
+    std::snprintf(lines[n++], 64, " input    %6.2f  handlers %6.2f", p.inputDecodeUs / 1000, p.inputHandlersUs / 1000);
+    std::snprintf(lines[n++], 64, " timers   %6.2f  end-frame %5.2f", p.callbacksUs / 1000, p.endOfFrameUs / 1000);
+    std::snprintf(lines[n++], 64, " layout   %6.2f  draw     %6.2f", p.layoutUs / 1000, p.drawUs / 1000);
+    for (const frameProfile::containerCost* c : top) {
+        if (!c) break;
+        const std::string label = utf8Prefix(c->c->label.empty() ? "(unnamed)" : c->c->label, 20);
+        // Pad by columns, not bytes, so accented labels line up
+        const int pad = std::max(0, 21 - measureColumns(label));
+        std::snprintf(lines[n++], 64, "   %s%*s%9.2f", label.c_str(), pad, "", c->us / 1000);
+    }
+    std::snprintf(lines[n++], 64, " compose  %6.2f", p.composeUs / 1000);
+    std::snprintf(lines[n++], 64, " diff %5.2f encode %5.2f write %5.2f", p.diffUs / 1000, p.encodeUs / 1000, p.writeUs / 1000);
+    std::snprintf(lines[n++], 64, " rows %4zu cells %6zu bytes %7zu", p.dirtyRows, p.cellsEmitted, p.bytes);
+
+    if (cols < kHudWidth + 2 || rows < n + 2) { hideSurface(hudLayer); return; }
+    const rect area{cols - kHudWidth - 1, 1, kHudWidth, n};
+    const color fg = {230, 230, 230, 255};
+    const color bg = {40, 20, 60, 255};
+    beginSurface(hudLayer, area, std::numeric_limits<int>::max());
+    fillRect(area.x, area.y, area.w, area.h, fg, bg);
+    for (int i = 0; i < n; ++i) drawString(lines[i], fg, bg, area.x, area.y + i);
+    endSurface();
+}
@@ -0,0 +1,145 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+// Changed cells below which a frame is encoded serially: waking the workers costs more than it
+// saves. In render_bench the bands only break even on full repaints (12000 cells at 200x60), so
+// everything short of a full repaint of a large terminal stays serial.
+const size_t kParallelMinCells = 16384;
+const size_t kSampleRows = 8; // changedCellsReach
+const int kBandsPerThread = 2; // a few more bands than threads evens out unequal bands
+}
+
+void bandPool::start(int workers) {
+    if (count > 0 || workers <= 0) return;
+    stopping = false;
+    count = workers;
+    // Passed in rather than read by the thread, which may first run after a batch has begun
+    const unsigned seen = batch;
+    for (int i = 0; i < workers; ++i) threads.emplace_back([this, seen] { loop(seen); });
+}
+
+void bandPool::stop() {
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) t.join();
+    threads.clear();
+    count = 0;
+}
+
+void bandPool::run(int n, const std::function<void(int)>& fn) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &fn;
+        jobs = n;
+        next.store(0, std::memory_order_relaxed);
+        finished = 0;
+        ++batch;
+    }
+    wake.notify_all();
+    work();
+    // Every worker has to be through the batch before job and jobs change for the next one
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return finished == count; });
+}
+
+void bandPool::work() {
+    for (int i = next.fetch_add(1); i < jobs; i = next.fetch_add(1)) (*job)(i);
+}
+
+void bandPool::loop(unsigned seen) {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [&] { return stopping || batch != seen; });
+        if (stopping) return;
+        seen = batch;
+        guard.unlock();
+        work();
+        guard.lock();
+        if (++finished == count) done.notify_one();
+    }
+}
+
+void TUImanager::setParallelEncode(int threads) {
+    if (threads == pool.workers()) return;
+    pool.stop();
+    pool.start(threads);
+    bands.clear();
+}
+
+bool TUImanager::changedCellsReach(size_t limit) const {
+    size_t dirtyRows = 0;
+    for (int y = 0; y < rows; ++y) dirtyRows += backRowHash[y] != frontRowHash[y];
+    if (dirtyRows * static_cast<size_t>(cols) < limit) return false;
+    // A changed row hash can stand for a single changed glyph, so count the cells themselves, in
+    // every kSampleRows-th dirty row: comparing them all would cost a sparse frame a third more
+    size_t changed = 0, seen = 0;
+    for (int y = 0; y < rows; ++y) {
+        if (backRowHash[y] == frontRowHash[y] || seen++ % kSampleRows != 0) continue;
+        const cell* back = &screenBuffer[static_cast<size_t>(y) * cols];
+        const cell* front = &frontBuffer[static_cast<size_t>(y) * cols];
+        for (int x = 0; x < cols; ++x) changed += !cellVisiblyEqual(back[x], front[x]);
+        if (changed * kSampleRows >= limit) return true;
+    }
+    return false;
+}
+
+void TUImanager::encodeBand(rowBand& b) {
+    b.enc.beginBand();
+    b.entry = b.enc.saveState();
+    b.rows.clear();
+    for (int y = b.y0; y < b.y1; ++y) {
+        if (backRowHash[y] == frontRowHash[y]) continue;
+        const size_t rowBase = static_cast<size_t>(y) * cols;
+        const size_t cells = b.enc.encodeRow(&screenBuffer[rowBase], &frontBuffer[rowBase], y);
+        b.rows.push_back({y, b.enc.out.size(), cells, b.enc.saveState()});
+    }
+}
+
+bool TUImanager::encodeBands(bool& started) {
+    if (!changedCellsReach(kParallelMinCells)) return false;
+
+    const auto encodeStart = std::chrono::steady_clock::now();
+    const int n = std::min(rows, (pool.workers() + 1) * kBandsPerThread);
+    bands.resize(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        rowBand& b = bands[i];
+        b.y0 = rows * i / n;
+        b.y1 = rows * (i + 1) / n;
+        b.enc.opts = encoder.opts;
+        b.enc.styles = &styles;
+        b.enc.setScreenSize(cols, rows);
+    }
+    pool.run(n, [this](int i) { encodeBand(bands[i]); });
+
+    // Splice the bands in order. A band started from an unknown state, so its first rows are
+    // encoded again here from the real one until both encoders stand in the same state; from
+    // there on the band's bytes are exactly what this encoder would have written.
+    for (rowBand& b : bands) {
+        for (size_t i = 0; i < b.rows.size(); ++i) {
+            if (!started) { encoder.beginFrame(); started = true; }
+            if (encoder.saveState() == (i == 0 ? b.entry : b.rows[i - 1].after)) {
+                const size_t from = i == 0 ? 0 : b.rows[i - 1].end;
+                encoder.out.put(b.enc.out.data() + from, b.enc.out.size() - from);
+                for (; i < b.rows.size(); ++i) lastFrame.cellsEmitted += b.rows[i].cells;
+                encoder.restoreState(b.rows.back().after);
+                break;
+            }
+            const size_t rowBase = static_cast<size_t>(b.rows[i].y) * cols;
+            lastFrame.cellsEmitted += encoder.encodeRow(&screenBuffer[rowBase], &frontBuffer[rowBase], b.rows[i].y);
+        }
+        // Only now: the rows encoded again above needed what the terminal showed before
+        for (const bandRow& r : b.rows) {
+            ++lastFrame.rowsScanned;
+            frameRows.push_back(r.y);
+            const size_t rowBase = static_cast<size_t>(r.y) * cols;
+            std::memcpy(&frontBuffer[rowBase], &screenBuffer[rowBase], static_cast<size_t>(cols) * sizeof(cell));
+            frontRowHash[r.y] = backRowHash[r.y];
+        }
+    }
+    profileCur.encodeUs += usSince(encodeStart);
+    return true;
+}
@@ -0,0 +1,107 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+// Bytes for the margin/region setup, cursor placement, SU/SD and reset around a scroll, roughly
+const size_t kScrollOverhead = 32;
+}
+
+void frameEncoder::scrollRegion(const rect& r, int dy) {
+    const bool margins = r.x > 0 || r.x + r.w < cols;
+    if (margins) {
+        out.put("\x1b[?69h\x1b[", 8);
+        out.putUInt(static_cast<unsigned>(r.x + 1));
+        out.put(';');
+        out.putUInt(static_cast<unsigned>(r.x + r.w));
+        out.put('s');
+    }
+    out.put("\x1b[", 2);
+    out.putUInt(static_cast<unsigned>(r.y + 1));
+    out.put(';');
+    out.putUInt(static_cast<unsigned>(r.y + r.h));
+    out.put('r');
+    // DECSTBM and DECSLRM home the cursor; park it inside the region before scrolling
+    forgetCursor();
+    moveTo(r.x, r.y);
+    emitCSI(static_cast<unsigned>(dy > 0 ? dy : -dy), dy > 0 ? 'S' : 'T');
+    out.put("\x1b[r", 3);
+    if (margins) out.put("\x1b[?69l", 6); // leaving DECLRMM also drops the left/right margins
+    forgetCursor();
+}
+
+void TUImanager::hintScroll(const rect& area, int dy) {
+    if (dy == 0 || encoder.opts.scrolls == scrollNone) return;
+    scrollHints.push_back({area, dy});
+}
+
+size_t TUImanager::bandCost(const rect& band, int dy) {
+    costEncoder.opts = encoder.opts;
+    costEncoder.opts.syncUpdates = false;
+    costEncoder.setScreenSize(cols, rows);
+    costEncoder.beginFrame();
+    cell unknown{};
+    unknown.style = styleUnknown;
+    std::vector<cell>& front = scrollScratch;
+    front.resize(static_cast<size_t>(cols));
+    for (int y = band.y; y < band.y + band.h; ++y) {
+        const size_t rowBase = static_cast<size_t>(y) * cols;
+        std::memcpy(front.data(), &frontBuffer[rowBase], static_cast<size_t>(cols) * sizeof(cell));
+        const int src = y + dy;
+        if (dy != 0 && src >= band.y && src < band.y + band.h) {
+            std::memcpy(&front[band.x], &frontBuffer[static_cast<size_t>(src) * cols + band.x], static_cast<size_t>(band.w) * sizeof(cell));
+        } else if (dy != 0) {
+            std::fill(front.begin() + band.x, front.begin() + band.x + band.w, unknown);
+        }
+        costEncoder.encodeRow(&screenBuffer[rowBase], front.data(), y);
+    }
+    return costEncoder.out.size();
+}
+
+bool TUImanager::applyScrollHints() {
+    bool started = false;
+    for (const scrollHintEntry& hint : scrollHints) {
+        int x = hint.area.x, y = hint.area.y, w = hint.area.w, h = hint.area.h;
+        const int dy = hint.dy;
+        if (!clipRect(x, y, w, h) || std::abs(dy) >= h) continue;
+        rect band{x, y, w, h};
+        if (w < cols) {
+            // A wide glyph straddling a margin would be torn apart by the scroll
+            bool clean = encoder.opts.scrolls == scrollMargins;
+            for (int yy = y; yy < y + h && clean; ++yy) {
+                const cell* front = &frontBuffer[static_cast<size_t>(yy) * cols];
+                if (front[x].glyphLen == 0 || (front[x + w - 1].flags & cellWide)) clean = false;
+            }
+            // Without margins the whole rows move, and whatever shares them is repainted
+            if (!clean) band = rect{0, y, cols, h};
+        }
+
+        // Encode the band's rows both ways into a scratch encoder and keep the cheaper one
+        const size_t stay = bandCost(band, 0);
+        const size_t shifted = bandCost(band, dy);
+        if (shifted + kScrollOverhead >= stay) continue;
+
+        if (!started) { encoder.beginFrame(); started = true; }
+        encoder.scrollRegion(band, dy);
+        ++lastFrame.regionsScrolled;
+
+        // Mirror the scroll in frontBuffer; exposed rows hold an unknown background
+        cell unknown{};
+        unknown.style = styleUnknown;
+        const size_t span = static_cast<size_t>(band.w) * sizeof(cell);
+        for (int i = 0; i < band.h; ++i) {
+            const int yy = dy > 0 ? band.y + i : band.y + band.h - 1 - i;
+            const int src = yy + dy;
+            cell* dst = &frontBuffer[static_cast<size_t>(yy) * cols + band.x];
+            if (src >= band.y && src < band.y + band.h) std::memcpy(dst, &frontBuffer[static_cast<size_t>(src) * cols + band.x], span);
+            else std::fill(dst, dst + band.w, unknown);
+        }
+        for (int yy = band.y; yy < band.y + band.h; ++yy) {
+            const cell* row = &frontBuffer[static_cast<size_t>(yy) * cols];
+            uint64_t rowHash = 0;
+            for (int i = 0; i < cols; ++i) rowHash ^= cellHash(row[i], i);
+            frontRowHash[yy] = rowHash;
+            frameRows.push_back(yy);
+        }
+    }
+    scrollHints.clear();
+    return started;
+}
@@ -0,0 +1,144 @@
+#include "chrmaTUI.hpp"
+
+namespace {
+inline size_t slotOf(uint64_t key, size_t mask) { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 40) & mask; }
+}
+
+styleTable::styleTable() {
+    entries.push_back({0, 0});
+    rehash(256);
+}
+
+uint16_t styleTable::internSlow(uint64_t key) {
+    const size_t mask = slots.size() - 1;
+    size_t i = slotOf(key, mask);
+    for (; slots[i] != styleUnknown; i = (i + 1) & mask) {
+        const entry& e = entries[slots[i]];
+        if (((uint64_t(e.fg) << 24) | e.bg) == key) {
+            lastKey = key;
+            lastId = slots[i];
+            return lastId;
+        }
+    }
+    if (entries.size() >= styleUnknown) return styleUnknown;
+    const uint16_t id = static_cast<uint16_t>(entries.size());
+    entries.push_back({static_cast<uint32_t>(key >> 24), static_cast<uint32_t>(key & 0xFFFFFF)});
+    slots[i] = id;
+    if (entries.size() * 2 > slots.size()) rehash(slots.size() * 2); // keep probes short
+    lastKey = key;
+    lastId = id;
+    return id;
+}
+
+void styleTable::rehash(size_t slotCount) {
+    slots.assign(slotCount, styleUnknown);
+    const size_t mask = slotCount - 1;
+    for (size_t id = 0; id < entries.size(); ++id) {
+        const uint64_t key = (uint64_t(entries[id].fg) << 24) | entries[id].bg;
+        size_t i = slotOf(key, mask);
+        while (slots[i] != styleUnknown) i = (i + 1) & mask;
+        slots[i] = static_cast<uint16_t>(id);
+    }
+}
+
+bool styleTable::compact(const std::vector<uint8_t>& live, std::vector<uint16_t>& remap) {
+    if (std::find(live.begin() + 1, live.end(), 0) == live.end()) return false;
+    remap.assign(entries.size(), 0);
+    size_t kept = 0;
+    for (size_t id = 0; id < entries.size(); ++id) {
+        if (id != 0 && !live[id]) continue;
+        remap[id] = static_cast<uint16_t>(kept);
+        entries[kept++] = entries[id];
+    }
+    entries.resize(kept);
+    size_t slotCount = 256;
+    while (kept * 2 > slotCount) slotCount *= 2;
+    rehash(slotCount);
+    nearCache.clear();
+    lastKey = 0;
+    lastId = 0;
+    return true;
+}
+
+uint16_t styleTable::nearest(uint32_t fg, uint32_t bg) {
+    // 3 bits per channel of each color; the bucket's middle stands for all of it
+    auto quantize = [](uint32_t c) { return ((c >> 21) & 7) << 6 | ((c >> 13) & 7) << 3 | ((c >> 5) & 7); };
+    auto middle = [](uint32_t q) { return ((q >> 6) << 21) | (((q >> 3) & 7) << 13) | ((q & 7) << 5) | 0x101010u; };
+    auto dist = [](uint32_t a, uint32_t b) {
+        int d = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            const int c = int((a >> shift) & 0xFF) - int((b >> shift) & 0xFF);
+            d += c * c;
+        }
+        return d;
+    };
+    if (nearCache.empty()) nearCache.assign(size_t(1) << 18, styleUnknown);
+    const uint32_t qfg = quantize(fg), qbg = quantize(bg);
+    uint16_t& id = nearCache[qfg << 9 | qbg];
+    if (id == styleUnknown) {
+        const uint32_t wantFg = middle(qfg), wantBg = middle(qbg);
+        int best = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const int d = dist(entries[i].fg, wantFg) + dist(entries[i].bg, wantBg);
+            if (d < best) {
+                best = d;
+                id = static_cast<uint16_t>(i);
+            }
+        }
+    }
+    return id;
+}
+
+// Every id in use is in one of the layers, in what render() compares against or in the row
+// compositeRow is interning. Renumbering them changes no cell's colors, but the row hashes are
+// over the ids and have to be redone.
+bool TUImanager::compactStyles() {
+    auto rowHash = [&](const std::vector<cell>& cells, int y) {
+        uint64_t h = 0;
+        for (int x = 0; x < cols; ++x) h ^= cellHash(cells[static_cast<size_t>(y) * cols + x], x);
+        return h;
+    };
+    // A front row hash that is not the hash of its row (invalidateFront) must stay that way
+    const bool committed = committedFront.size() == frontBuffer.size();
+    std::vector<uint8_t> frontKnown(rows), committedKnown(rows);
+    for (int y = 0; y < rows; ++y) {
+        frontKnown[y] = frontRowHash[y] == rowHash(frontBuffer, y);
+        committedKnown[y] = committed && committedRowHash[y] == rowHash(committedFront, y);
+    }
+
+    std::vector<uint8_t> live(styles.size(), 0);
+    auto mark = [&](const std::vector<cell>& cells) {
+        for (const cell& c : cells) {
+            if (c.style != styleUnknown) live[c.style] = 1;
+        }
+    };
+    mark(baseLayer);
+    for (const surface* s : surfaces) mark(s->cells);
+    mark(screenBuffer);
+    mark(frontBuffer);
+    mark(committedFront);
+    for (uint16_t id : styleScratch) live[id] = 1;
+    std::vector<uint16_t> remap;
+    if (!styles.compact(live, remap)) return false;
+    auto apply = [&](std::vector<cell>& cells) {
+        for (cell& c : cells) {
+            if (c.style != styleUnknown) c.style = remap[c.style];
+        }
+    };
+    apply(baseLayer);
+    for (surface* s : surfaces) apply(s->cells);
+    apply(screenBuffer);
+    apply(frontBuffer);
+    apply(committedFront);
+    for (uint16_t& id : styleScratch) id = remap[id];
+
+    for (int y = 0; y < rows; ++y) {
+        recomputeRowHash(y);
+        frontRowHash[y] = frontKnown[y] ? rowHash(frontBuffer, y) : ~backRowHash[y];
+        if (committed) committedRowHash[y] = committedKnown[y] ? rowHash(committedFront, y) : ~backRowHash[y];
+    }
+    encoder.forgetStyles();
+    costEncoder.forgetStyles();
+    for (rowBand& b : bands) b.enc.forgetStyles();
+    return true;
+}
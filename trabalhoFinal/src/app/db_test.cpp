@@ -1,6 +1,7 @@
 #include "app/db.hpp"
 #include "app/db_test.hpp"
 #include "app/models.hpp"
+#include "app/repos/book_repository.hpp"
 #include "app/repos/student_repository.hpp"
 #include "app/schema.hpp"
 
@@ -140,6 +141,29 @@ void runDatabaseTests() {
             std::cout << "✓ Remaining students: " << studentRepo.count() << "\n";
         }
 
+        // Test 11: Books a page at a time
+        std::cout << "\n--- Test 11: Book pages ---\n";
+        repos::BookRepository bookRepo(db);
+        for (const char* title : {"Dom Casmurro", "Capitães da Areia", "Dom Casmurro", "Iracema", "O Cortiço"}) {
+            models::Book book(title, "Autor", 1900, std::nullopt, 1);
+            bookRepo.create(book);
+        }
+        auto allBooks = bookRepo.findAll();
+        std::vector<models::Book> paged;
+        for (int64_t offset = 0; offset < bookRepo.count(); offset += 2) {
+            for (const auto& b : bookRepo.findPage(offset, 2)) paged.push_back(b);
+        }
+        bool samePages = paged.size() == allBooks.size();
+        for (size_t i = 0; samePages && i < paged.size(); ++i) {
+            samePages = paged[i].title == allBooks[i].title;
+        }
+        // The two "Dom Casmurro" straddle the first page boundary: neither may repeat
+        if (samePages && paged[1].id != paged[2].id) {
+            std::cout << "✓ Pages of 2 list all " << paged.size() << " books in title order\n";
+        } else {
+            std::cout << "✗ FAILED: Pages do not match findAll\n";
+        }
+
         std::cout << "\n=== All Tests Passed! ===\n";
 
     } catch (const std::exception& ex) {
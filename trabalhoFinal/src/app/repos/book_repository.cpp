@@ -155,6 +155,27 @@ std::vector<models::Book> BookRepository::findAll(bool availableOnly) const {
     return books;
 }
 
+std::vector<models::Book> BookRepository::findPage(int64_t offset, int64_t limit) const {
+    // id breaks ties between equal titles so consecutive pages neither repeat nor skip a book
+    constexpr auto sql = R"sql(
+        SELECT id, title, author, published_year, isbn, copies_available
+        FROM books
+        ORDER BY title, id
+        LIMIT ? OFFSET ?
+    )sql";
+
+    Statement stmt(db_.handle(), sql);
+    stmt.bind(1, limit);
+    stmt.bind(2, offset);
+
+    std::vector<models::Book> books;
+    while (stmt.step()) {
+        books.push_back(mapRowToBook(stmt));
+    }
+
+    return books;
+}
+
 bool BookRepository::update(const models::Book& book) {
     if (book.id == 0) {
         throw std::runtime_error("Cannot update book: ID not set");
@@ -34,6 +34,7 @@ void initializeSchema(sqlite3* db) {
     // Create indexes
     executeSql(db, kCreateStudentRegNumberIndex);
     executeSql(db, kCreateStudentActiveIndex);
+    executeSql(db, kCreateBookTitleIndex);
     executeSql(db, kCreateLoanStudentIndex);
     executeSql(db, kCreateLoanBookIndex);
     executeSql(db, kCreateLoanUnreturnedIndex);
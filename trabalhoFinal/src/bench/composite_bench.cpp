@@ -0,0 +1,90 @@
+// CPU benchmark for the rectangle primitives against the per-cell drawing they replace.
+//
+// Each scenario repaints the whole back buffer many times (nothing is rendered to the terminal):
+// an opaque fill, a translucent modal backdrop and an animated gradient, once cell by cell through
+// drawGlyph/drawString and once through fillRect/blendRect/gradientRect.
+//
+// Build from trabalhoFinal/:
+//   g++ -std=c++17 -O2 -Ilib/chrmaTUI src/bench/composite_bench.cpp lib/chrmaTUI/*.cpp -o composite_bench
+// Usage: ./composite_bench [cols] [rows] [frames]
+
+#include "chrmaTUI.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+double timeFrames(int frames, const std::function<void(int)>& frame) {
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) frame(f);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+color shade(int f) {
+    return {static_cast<uint8_t>(f * 7), static_cast<uint8_t>(40 + f % 100), 90, 255};
+}
+
+}
+
+int main(int argc, char** argv) {
+    int cols = argc > 1 ? std::atoi(argv[1]) : 200;
+    int rows = argc > 2 ? std::atoi(argv[2]) : 60;
+    int frames = argc > 3 ? std::atoi(argv[3]) : 300;
+
+    headlessBackend term(rows, cols);
+    TUImanager tui(term);
+    const color white = {255, 255, 255, 255};
+
+    struct scenario {
+        const char* name;
+        std::function<void(int)> perCell;
+        std::function<void(int)> rect;
+    };
+    scenario scenarios[] = {
+        {"opaque fill",
+         [&](int f) {
+             for (int y = 0; y < rows; ++y)
+                 for (int x = 0; x < cols; ++x) tui.drawGlyph(" ", 1, white, shade(f), x, y);
+         },
+         [&](int f) { tui.fillRect(0, 0, cols, rows, white, shade(f)); }},
+        {"backdrop alpha 128",
+         [&](int f) {
+             color dim = shade(f);
+             dim.a = 128;
+             for (int y = 0; y < rows; ++y)
+                 for (int x = 0; x < cols; ++x) tui.drawGlyph(" ", 1, white, dim, x, y);
+         },
+         [&](int f) {
+             color dim = shade(f);
+             dim.a = 128;
+             tui.fillRect(0, 0, cols, rows, white, dim);
+         }},
+        {"horizontal gradient",
+         [&](int f) {
+             // What paletteDemo does: one drawString per cell with a computed color
+             for (int y = 0; y < rows; ++y)
+                 for (int x = 0; x < cols; ++x) {
+                     color c = {static_cast<uint8_t>((x * 255 / cols + f) & 0xFF), static_cast<uint8_t>(y * 4), 128, 255};
+                     tui.drawString(" ", white, c, x, y);
+                 }
+         },
+         [&](int f) {
+             tui.gradientRect(0, 0, cols, rows, {static_cast<uint8_t>(f), 0, 128, 255},
+                              {static_cast<uint8_t>(255 - f), 200, 128, 255});
+         }},
+    };
+
+    std::printf("composite cost, %dx%d, %d frames\n", cols, rows, frames);
+    std::printf("%-22s %14s %14s %8s\n", "scenario", "per-cell us", "rect us", "speedup");
+    for (const scenario& s : scenarios) {
+        tui.clearScreen({0, 0, 0, 255});
+        double perCell = timeFrames(frames, s.perCell);
+        tui.clearScreen({0, 0, 0, 255});
+        double rect = timeFrames(frames, s.rect);
+        std::printf("%-22s %14.1f %14.1f %7.2fx\n", s.name, perCell, rect, rect > 0 ? perCell / rect : 0.0);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+// Byte-count benchmark for the frame encoder on the library manager's screens.
+//
+// Replays a short session (first paint, menu navigation, list scrolling, a modal with typing)
+// with the plain encoder (absolute CUP per span, SGR re-sent on every row, blanks printed as
+// spaces), with the cursor/erase optimizer, with REP on top, at 256/16 colors, and with scroll
+// regions (full-width rows, and left/right margins), and reports bytes per scenario. Runs on a
+// headlessBackend, whose decoded screen is checked against the back buffer after every frame.
+//
+// Build from trabalhoFinal/:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/chrmaTUI src/bench/encoder_bench.cpp lib/chrmaTUI/*.cpp
+//       src/ui/*.cpp src/ui/modals/*.cpp src/app/db.cpp src/app/schema.cpp src/app/repos/*.cpp
+//       -lsqlite3 -o encoder_bench
+// Usage: ./encoder_bench [cols] [rows] [books]
+
+#include "app/db.hpp"
+#include "app/schema.hpp"
+#include "ui/ui_common.hpp"
+#include "ui/modals/book_modals.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct scenarioResult {
+    std::string name;
+    size_t frames = 0;
+    size_t bytes = 0;
+    size_t cells = 0;
+};
+
+// screenDiff counts cells where the decoded output disagreed with what was drawn, over all frames
+std::vector<scenarioResult> runSession(const frameEncoder::options& opts, int cols, int rows, int bookCount,
+                                       size_t& screenDiff) {
+    app::Database db(":memory:");
+    app::schema::initializeSchema(db.handle());
+    app::repos::BookRepository bookRepo(db);
+    for (int i = 0; i < bookCount; ++i) {
+        app::models::Book book("Título de exemplo número " + std::to_string(i), "Autor " + std::to_string(i % 97),
+                               1990 + i % 30, std::nullopt, 1 + i % 5);
+        bookRepo.create(book);
+    }
+
+    headlessBackend term(rows, cols);
+    TUImanager tui(term);
+    tui.encoder.opts = opts;
+
+    // Same layout as ui::runTestUI: a 30% action menu and the books view on the right
+    int menuWidth = tui.cols * 30 / 100;
+    container actionsMenu({0, 0}, {menuWidth, tui.rows}, ui::defaultModalStyle(), "Ações");
+    actionsMenu.setDefaultElementStyle(ui::defaultModalStyle());
+    actionsMenu.setInheritStyle(true);
+    int rightW = tui.cols - menuWidth;
+    container booksView({menuWidth, 0}, {rightW, tui.rows}, ui::defaultModalStyle(), "Livros");
+    booksView.setDefaultElementStyle(ui::defaultModalStyle());
+    booksView.setInheritStyle(true);
+
+    Text viewSectionLabel("─── Visualizar ───", {0, 0});
+    viewSectionLabel.setPercentPosition(5, 3);
+    std::vector<Button*> buttons;
+    const char* labels[] = {"Livros", "Estudantes", "Empréstimos", "Buscar", "+ Livro", "+ Estudante",
+                            "Editar Livro", "Editar Estudante", "Emprestar", "Devolver"};
+    actionsMenu.addElement(&viewSectionLabel);
+    for (int i = 0; i < 10; ++i) {
+        Button* b = new Button(labels[i], {0, 0}, 18, 3);
+        b->setPercentPosition(8, 8 + i * 9);
+        buttons.push_back(b);
+        actionsMenu.addElement(b);
+    }
+
+    ui::BookListSource booksSource(bookRepo);
+    ListView booksList("", {}, {0, 0}, rightW - 4, tui.rows - 4, 15);
+    booksList.setSource(&booksSource);
+    booksList.setPercentPosition(2, 5);
+    booksList.setPercentW(96);
+    booksList.setPercentH(90);
+    booksView.addElement(&booksList);
+
+    ui::BookRegistrationModal bookModal(tui, &bookRepo);
+    bookModal.modalContainer->tui = &tui;
+
+    tui.containerID = &actionsMenu;
+    actionsMenu.tui = &tui;
+    booksView.tui = &tui;
+    actionsMenu.focusedIndex = 1;
+    buttons[0]->notifyHover(tui, true);
+
+    std::vector<scenarioResult> results;
+    auto frame = [&](scenarioResult& r) {
+        actionsMenu.render(tui);
+        booksView.render(tui);
+        bookModal.render(tui);
+        tui.runEndOfFrame();
+        if (tui.hasDirty()) tui.render();
+        screenDiff += term.mismatches(tui);
+        r.frames++;
+        r.bytes += tui.lastFrame.bytesEmitted;
+        r.cells += tui.lastFrame.cellsEmitted;
+    };
+
+    scenarioResult paint{"first paint"};
+    tui.clearScreen(ui::BACKGROUND);
+    frame(paint);
+    results.push_back(paint);
+
+    scenarioResult menu{"menu navigation x8"};
+    for (int i = 0; i < 8; ++i) { actionsMenu.navigate(DOWN); frame(menu); }
+    results.push_back(menu);
+
+    scenarioResult scroll{"list scroll x40"};
+    tui.focusContainer(&booksView, 0);
+    tui.userState = CAPTURE;
+    frame(scroll);
+    scroll = scenarioResult{"list scroll x40"};
+    for (int i = 0; i < 40; ++i) { booksList.notifyInteract(DOWN, 0, tui.userState, tui); frame(scroll); }
+    results.push_back(scroll);
+    tui.userState = NAVIGATING;
+
+    scenarioResult open{"modal open"};
+    bookModal.open(tui, &actionsMenu);
+    frame(open);
+    results.push_back(open);
+
+    scenarioResult typing{"modal typing x24"};
+    tui.userState = CAPTURE;
+    for (char c : std::string("Dom Casmurro, de Machado")) {
+        bookModal.titleInput->notifyInteract(UNKNOWN, c, tui.userState, tui);
+        frame(typing);
+    }
+    tui.userState = NAVIGATING;
+    results.push_back(typing);
+
+    scenarioResult close{"modal close"};
+    bookModal.close(tui, &actionsMenu);
+    frame(close);
+    results.push_back(close);
+
+    for (Button* b : buttons) delete b;
+    return results;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int cols = argc > 1 ? std::atoi(argv[1]) : 160;
+    int rows = argc > 2 ? std::atoi(argv[2]) : 48;
+    int books = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    struct config {
+        const char* name;
+        frameEncoder::options opts;
+    };
+    std::vector<config> configs(7);
+    configs[0].name = "plain";
+    configs[0].opts.relativeMoves = false;
+    configs[0].opts.eraseRuns = false;
+    configs[0].opts.carryColors = false;
+    configs[1].name = "optimized";
+    configs[2].name = "+REP";
+    configs[2].opts.repeatRuns = repeatAny;
+    configs[3] = configs[2];
+    configs[3].name = "+REP 256c";
+    configs[3].opts.depth = depth256;
+    configs[4] = configs[2];
+    configs[4].name = "+REP 16c";
+    configs[4].opts.depth = depth16;
+    configs[5] = configs[2];
+    configs[5].name = "+scroll rows";
+    configs[5].opts.scrolls = scrollRows;
+    configs[6] = configs[2];
+    configs[6].name = "+scroll LR";
+    configs[6].opts.scrolls = scrollMargins;
+
+    std::vector<std::vector<scenarioResult>> results;
+    std::vector<size_t> screenDiffs(configs.size(), 0);
+    for (size_t k = 0; k < configs.size(); ++k) results.push_back(runSession(configs[k].opts, cols, rows, books, screenDiffs[k]));
+
+    std::printf("encoder byte count, %dx%d, %d books\n", cols, rows, books);
+    std::printf("%-22s %8s", "scenario", "frames");
+    for (const config& c : configs) std::printf(" %11s B", c.name);
+    std::printf("\n");
+    std::vector<size_t> totals(configs.size(), 0);
+    for (size_t i = 0; i < results[0].size(); ++i) {
+        std::printf("%-22s %8zu", results[0][i].name.c_str(), results[0][i].frames);
+        for (size_t k = 0; k < configs.size(); ++k) {
+            totals[k] += results[k][i].bytes;
+            std::printf(" %13zu", results[k][i].bytes);
+        }
+        std::printf("\n");
+    }
+    std::printf("%-22s %8s", "total", "");
+    for (size_t total : totals) std::printf(" %13zu", total);
+    std::printf("\n%-22s %8s", "vs plain", "");
+    for (size_t total : totals) std::printf(" %12.2fx", total ? double(totals[0]) / double(total) : 0.0);
+    std::printf("\n%-22s %8s", "cells off screen", "");
+    for (size_t diff : screenDiffs) std::printf(" %13zu", diff);
+    std::printf("\n");
+    for (size_t diff : screenDiffs) {
+        if (diff) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
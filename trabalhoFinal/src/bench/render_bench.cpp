@@ -0,0 +1,326 @@
+// Rendering benchmark suite for chrmaTUI, for tracking regressions between releases.
+//
+// Cases: the drawing primitives (drawString ASCII and multibyte, drawBox, clearRect), render() with
+// 1%, 10% and 100% of the cells changed, ListView and RichListView scrolling through 10^3..10^6
+// items (ListView also from a ListDataSource, scrolling and opening), Text word wrapping and
+// MultiLineInput editing. The render() cases run again on the parallel band encoder (_bands, one
+// worker per extra core). Everything runs on a headlessBackend that only counts the bytes (no
+// decoding), with the writer thread off.
+//
+// Output is CSV on stdout, one line per case:
+//   case,items,frames,cells_per_frame,ns_per_cell,bytes_per_frame,allocs_per_frame
+// cells_per_frame is what the case touches (the drawn area, or the changed cells for render()).
+// The primitive cases only draw into the base layer, so their bytes_per_frame is 0. Allocations
+// are calls to operator new from any thread (the band encoder's workers too), counted by this file.
+//
+// Build from trabalhoFinal/:
+//   g++ -std=c++17 -O2 -Ilib/chrmaTUI src/bench/render_bench.cpp lib/chrmaTUI/*.cpp -lpthread -o render_bench
+// Usage: ./render_bench [cols] [rows] [maxItems]
+//   e.g. ./render_bench 500 150 for a 4K dashboard
+
+#include "chrmaTUI.hpp"
+#include "elements.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+// Every replaceable form of new and delete, so each allocation is counted and freed in kind
+namespace {
+std::atomic<size_t> allocations{0}; // the bandPool workers allocate too
+
+void* countedAlloc(size_t n) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+// Out of line: inlined into a delete expression, GCC pairs the free() with operator new and warns
+__attribute__((noinline)) void release(void* p) noexcept { std::free(p); }
+}
+
+void* operator new(size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+
+namespace {
+
+const color kFg = {230, 230, 230, 255};
+const color kBg = {20, 24, 32, 255};
+const color kFgHi = {255, 255, 255, 255};
+const color kBgHi = {60, 70, 90, 255};
+const double kMinSeconds = 0.2; // per case
+const int kMaxFrames = 20000;
+
+standardStyle benchStyle() {
+    return {kFg, kBg, kFgHi, kBgHi};
+}
+
+// Deterministic, so runs are comparable
+struct lcg {
+    uint32_t s = 12345;
+    uint32_t next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+};
+
+// ListView rows made up on request, like a database-backed source without the database
+struct generatedRows : ListDataSource {
+    int n;
+    explicit generatedRows(int n) : n(n) {}
+    int count() override { return n; }
+    void itemAt(int i, std::string& out) override {
+        out = "[BK-" + std::to_string(100000 + i) + "] Título de exemplo número " + std::to_string(i);
+    }
+};
+
+struct caseResult {
+    std::string name;
+    size_t items = 0;
+    int frames = 0;
+    size_t cellsPerFrame = 0;
+    double nsPerCell = 0;
+    double bytesPerFrame = 0;
+    double allocsPerFrame = 0;
+};
+
+// Runs frame(f) until kMinSeconds have passed (at least 3 frames) after one untimed warm-up frame
+caseResult measure(const std::string& name, size_t items, size_t cellsPerFrame, headlessBackend& term,
+                   const std::function<void(int)>& frame) {
+    frame(0);
+    caseResult r;
+    r.name = name;
+    r.items = items;
+    r.cellsPerFrame = cellsPerFrame;
+    const size_t bytesBefore = term.bytesWritten;
+    const size_t allocsBefore = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    int f = 1;
+    while (f <= kMaxFrames && (f <= 3 || elapsed.count() < kMinSeconds)) {
+        frame(f++);
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    r.frames = f - 1;
+    r.nsPerCell = elapsed.count() * 1e9 / r.frames / static_cast<double>(std::max<size_t>(1, cellsPerFrame));
+    r.bytesPerFrame = static_cast<double>(term.bytesWritten - bytesBefore) / r.frames;
+    r.allocsPerFrame = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocsBefore) / r.frames;
+    return r;
+}
+
+// A full-screen container holding one element, focused and capturing input like the app's views
+struct harness {
+    headlessBackend term;
+    TUImanager tui;
+    container box;
+    harness(int rows, int cols) : term(rows, cols), tui(term), box({0, 0}, {cols, rows}, benchStyle(), "bench") {
+        term.decodeScreen = false;
+        box.setDefaultElementStyle(benchStyle());
+        box.setInheritStyle(true);
+        box.tui = &tui;
+        tui.containerID = &box;
+    }
+    void focus(element* e) {
+        box.addElement(e);
+        tui.focusContainer(&box, 0);
+        tui.userState = CAPTURE;
+    }
+    void frame() {
+        box.render(tui);
+        tui.runEndOfFrame();
+        if (tui.hasDirty()) tui.render();
+    }
+};
+
+void primitiveCases(int cols, int rows, std::vector<caseResult>& out) {
+    headlessBackend term(rows, cols);
+    term.decodeScreen = false;
+    TUImanager tui(term);
+    const size_t screen = static_cast<size_t>(rows) * cols;
+
+    std::vector<std::string> ascii, multibyte;
+    for (int v = 0; v < 2; ++v) {
+        std::string a, m;
+        // Accented Latin, box drawing and a wide CJK glyph: 2, 3 and 3-byte sequences
+        const char* mix[] = {"ç", "ã", "─", "│", "é", "日"};
+        for (int x = 0; x < cols; ++x) a += static_cast<char>('a' + (x + v) % 26);
+        for (int x = 0; x < cols;) {
+            const char* g = mix[(x + v) % 6];
+            const int w = std::strcmp(g, "日") == 0 ? 2 : 1;
+            if (x + w > cols) break;
+            m += g;
+            x += w;
+        }
+        ascii.push_back(a);
+        multibyte.push_back(m);
+    }
+    out.push_back(measure("drawString_ascii", 0, screen, term, [&](int f) {
+        for (int y = 0; y < rows; ++y) tui.drawString(ascii[f & 1], kFg, kBg, 0, y);
+    }));
+    out.push_back(measure("drawString_multibyte", 0, screen, term, [&](int f) {
+        for (int y = 0; y < rows; ++y) tui.drawString(multibyte[f & 1], kFg, kBg, 0, y);
+    }));
+
+    const int boxW = 20, boxH = 6;
+    const size_t boxCells = static_cast<size_t>(cols / boxW) * boxW * (rows / boxH) * boxH;
+    out.push_back(measure("drawBox", 0, boxCells, term, [&](int f) {
+        const color bg = (f & 1) ? kBg : kBgHi;
+        for (int y = 0; y + boxH <= rows; y += boxH)
+            for (int x = 0; x + boxW <= cols; x += boxW) tui.drawBox(x, y, boxW, boxH, kFg, bg, bg);
+    }));
+    out.push_back(measure("clearRect", 0, screen, term, [&](int f) {
+        tui.clearRect(0, 0, cols, rows, (f & 1) ? kBg : kBgHi);
+    }));
+
+    // render(): a painted screen with a share of its cells changed before each frame
+    tui.fillRect(0, 0, cols, rows, kFg, kBg, "x", 1);
+    tui.render();
+    lcg rng;
+    const int workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for (int threads : {0, workers}) {
+        tui.setParallelEncode(threads);
+        for (int percent : {1, 10, 100}) {
+            const size_t changed = std::max<size_t>(1, screen * percent / 100);
+            const std::string name = "render_" + std::to_string(percent) + "pct_dirty" + (threads ? "_bands" : "");
+            out.push_back(measure(name, 0, changed, term, [&](int f) {
+                if (percent == 100) {
+                    tui.fillRect(0, 0, cols, rows, kFg, (f & 1) ? kBgHi : kBg, (f & 1) ? "y" : "x", 1);
+                } else {
+                    for (size_t i = 0; i < changed; ++i) {
+                        const uint32_t v = rng.next();
+                        const char g = static_cast<char>('a' + v % 26);
+                        const color bg = {static_cast<uint8_t>(v >> 5), 40, 80, 255};
+                        tui.drawGlyph(&g, 1, kFg, bg, static_cast<int>(v / 26 % cols), static_cast<int>(v / 26 / cols % rows));
+                    }
+                }
+                tui.render();
+            }));
+        }
+    }
+}
+
+void listCases(int cols, int rows, size_t maxItems, std::vector<caseResult>& out) {
+    const size_t area = static_cast<size_t>(rows - 2) * (cols - 2);
+    for (size_t n = 1000; n <= maxItems; n *= 10) {
+        std::vector<std::string> items;
+        items.reserve(n);
+        for (size_t i = 0; i < n; ++i) items.push_back("[BK-" + std::to_string(100000 + i) + "] Título de exemplo número " + std::to_string(i));
+        harness h(rows, cols);
+        ListView list("", items, {0, 0}, cols - 4, rows - 4);
+        list.setPercentPosition(0, 0);
+        list.setPercentW(100);
+        list.setPercentH(100);
+        items = {};
+        h.focus(&list);
+        out.push_back(measure("ListView_scroll", n, area, h.term, [&](int) {
+            list.notifyInteract(DOWN, 0, h.tui.userState, h.tui);
+            h.frame();
+        }));
+    }
+    for (size_t n = 1000; n <= maxItems; n *= 10) {
+        generatedRows source(static_cast<int>(n));
+        harness h(rows, cols);
+        ListView list("", {}, {0, 0}, cols - 4, rows - 4);
+        list.setPercentPosition(0, 0);
+        list.setPercentW(100);
+        list.setPercentH(100);
+        list.setSource(&source);
+        h.focus(&list);
+        out.push_back(measure("ListView_source_scroll", n, area, h.term, [&](int) {
+            list.notifyInteract(DOWN, 0, h.tui.userState, h.tui);
+            h.frame();
+        }));
+        // Switching to the view: what it costs has to stay flat as the source grows
+        out.push_back(measure("ListView_source_open", n, area, h.term, [&](int) {
+            list.setSource(&source);
+            h.frame();
+        }));
+    }
+    for (size_t n = 1000; n <= maxItems; n *= 10) {
+        std::vector<RichListItem> items;
+        items.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            items.emplace_back(std::vector<std::string>{"Estudante " + std::to_string(i), "Matrícula 2024" + std::to_string(i)},
+                               benchStyle(), static_cast<int64_t>(i));
+        }
+        harness h(rows, cols);
+        RichListView list("", items, {0, 0}, cols - 4, rows - 4);
+        list.setPercentPosition(0, 0);
+        list.setPercentW(100);
+        list.setPercentH(100);
+        items = {};
+        h.focus(&list);
+        out.push_back(measure("RichListView_scroll", n, area, h.term, [&](int) {
+            list.notifyInteract(DOWN, 0, h.tui.userState, h.tui);
+            h.frame();
+        }));
+    }
+}
+
+void textCases(int cols, int rows, std::vector<caseResult>& out) {
+    const size_t area = static_cast<size_t>(rows - 2) * (cols - 2);
+    std::string paragraph;
+    while (paragraph.size() < area * 3 / 4) paragraph += "Capitu tinha olhos de ressaca, e a ação se passa no Rio de Janeiro. ";
+    {
+        harness h(rows, cols);
+        Text text(paragraph, {0, 0}, true, cols - 4);
+        h.box.addElement(&text);
+        out.push_back(measure("Text_wrap", paragraph.size(), area, h.term, [&](int f) {
+            // A different first word each frame so the wrap cannot be reused
+            text.content[0] = static_cast<char>('A' + f % 26);
+            text.invalidate();
+            h.frame();
+        }));
+    }
+    {
+        harness h(rows, cols);
+        MultiLineInput input("Notas", {0, 0}, cols - 4, rows - 4);
+        input.setPercentPosition(0, 0);
+        input.setPercentW(100);
+        input.setPercentH(100);
+        input.text = paragraph.substr(0, paragraph.size() / 2);
+        input.caretIndex = static_cast<int>(input.text.size() / 2);
+        h.focus(&input);
+        const std::string typed = "Dom Casmurro, de Machado de Assis. ";
+        out.push_back(measure("MultiLineInput_edit", input.text.size(), area, h.term, [&](int f) {
+            const char c = typed[static_cast<size_t>(f) % typed.size()];
+            if (f % 40 == 39) input.notifyInteract(SHIFT_ENTER, 0, h.tui.userState, h.tui);
+            else if (f % 10 == 9) input.notifyInteract(BACKSPACE, 0, h.tui.userState, h.tui);
+            else input.notifyInteract(UNKNOWN, c, h.tui.userState, h.tui);
+            h.frame();
+        }));
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    int cols = argc > 1 ? std::atoi(argv[1]) : 160;
+    int rows = argc > 2 ? std::atoi(argv[2]) : 48;
+    size_t maxItems = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    cols = std::max(cols, 20);
+    rows = std::max(rows, 8);
+
+    std::vector<caseResult> results;
+    primitiveCases(cols, rows, results);
+    listCases(cols, rows, maxItems, results);
+    textCases(cols, rows, results);
+
+    std::printf("case,items,frames,cells_per_frame,ns_per_cell,bytes_per_frame,allocs_per_frame\n");
+    for (const caseResult& r : results) {
+        std::printf("%s,%zu,%d,%zu,%.3f,%.1f,%.2f\n", r.name.c_str(), r.items, r.frames, r.cellsPerFrame,
+                    r.nsPerCell, r.bytesPerFrame, r.allocsPerFrame);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+// Test for the style table running out of ids.
+//
+// A 500x150 screen has more cells than there are style ids, so a frame with a different
+// background in every cell fills the table with ids that are all still on screen. Drawing has to
+// go on with the closest colors instead of hanging or storing styleUnknown, and once the screen
+// lets go of them the ids have to be reclaimed so exact colors come back.
+//
+// Build from trabalhoFinal/:
+//   g++ -std=c++17 -O2 -Ilib/chrmaTUI src/test/style_table_test.cpp lib/chrmaTUI/*.cpp -lpthread -o style_table_test
+// Usage: ./style_table_test
+
+#include "chrmaTUI.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const int kCols = 500;
+const int kRows = 150;
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    std::printf("%s %s\n", ok ? "✓" : "✗ FAILED:", what);
+    if (!ok) ++failures;
+}
+
+// A background no other cell of the screen has
+color uniqueBg(int x, int y, int salt) {
+    const int i = y * kCols + x + salt;
+    return {static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i >> 16 ^ salt), 255};
+}
+
+bool idsValid(const TUImanager& tui) {
+    for (int y = 0; y < kRows; ++y) {
+        for (int x = 0; x < kCols; ++x) {
+            if (tui.cellAt(x, y).style >= tui.styles.size()) return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main() {
+    std::printf("=== Style table tests ===\n\n");
+    headlessBackend term(kRows, kCols);
+    TUImanager tui(term);
+    const color fg = {230, 230, 230, 255};
+
+    std::printf("--- Every cell a new pair, cell by cell ---\n");
+    for (int y = 0; y < kRows; ++y) {
+        for (int x = 0; x < kCols; ++x) tui.drawGlyph("x", 1, fg, uniqueBg(x, y, 0), x, y);
+    }
+    tui.render();
+    check(tui.styles.size() <= styleUnknown, "table stays within 16-bit ids");
+    check(idsValid(tui), "every cell has an id of the table");
+    check(term.mismatches(tui) == 0, "terminal shows what the cells say");
+
+    std::printf("\n--- Every cell a new pair, through compositeRow, with the last frame on screen ---\n");
+    for (int y = 0; y < kRows; ++y) {
+        tui.gradientRect(0, y, kCols, 1, uniqueBg(0, y, 7), uniqueBg(kCols - 1, y, 7));
+    }
+    tui.render();
+    check(idsValid(tui), "every cell has an id of the table");
+    check(term.mismatches(tui) == 0, "terminal shows what the cells say");
+
+    std::printf("\n--- Ids are reclaimed once the screen lets go of them ---\n");
+    tui.fillRect(0, 0, kCols, kRows, fg, {0, 0, 0, 255});
+    tui.render();
+    tui.render();
+    bool exact = true;
+    for (int x = 0; x < kCols; ++x) tui.drawGlyph("x", 1, fg, uniqueBg(x, 0, 3), x, 0);
+    tui.render();
+    for (int x = 0; x < kCols; ++x) {
+        if (tui.styles.bg(tui.cellAt(x, 0).style) != packColor(uniqueBg(x, 0, 3))) exact = false;
+    }
+    check(exact, "a new row of pairs gets its exact colors");
+    check(term.mismatches(tui) == 0, "terminal shows what the cells say");
+
+    std::printf("\n%s\n", failures ? "=== Some tests FAILED ===" : "=== All Tests Passed! ===");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
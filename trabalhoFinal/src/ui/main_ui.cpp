@@ -9,6 +9,7 @@ NotificationManager* globalNotifications = nullptr;
 
 void runTestUI(app::Database& db) {
     TUImanager tui;
+    tui.setWriterThread(true); // a slow terminal or SSH link must not hold up input and DB work
     NotificationManager notifications;
     globalNotifications = &notifications;
     
@@ -17,8 +18,12 @@ void runTestUI(app::Database& db) {
     app::repos::LoanRepository loanRepo(db);
     
 
+    // Geometry is given in percent of the terminal so it follows resizes; the sizes below are
+    // only the initial values
     int menuWidth = tui.cols * 30 / 100;
     container actionsMenu({0, 0}, {menuWidth, tui.rows}, defaultModalStyle(), "Ações");
+    actionsMenu.setPercentPosition(0, 0);
+    actionsMenu.setPercentSize(30, 100);
     actionsMenu.setDefaultElementStyle(defaultModalStyle());
     actionsMenu.setInheritStyle(true);
     
@@ -27,18 +32,26 @@ void runTestUI(app::Database& db) {
 
     //initializing container contexts
     container booksView({rightX, 0}, {rightW, tui.rows}, defaultModalStyle(), "Livros");
+    booksView.setPercentPosition(30, 0);
+    booksView.setPercentSize(70, 100);
     booksView.setDefaultElementStyle(defaultModalStyle());
     booksView.setInheritStyle(true);
     
     container studentsView({rightX, 0}, {rightW, tui.rows}, defaultModalStyle(), "Estudantes");
+    studentsView.setPercentPosition(30, 0);
+    studentsView.setPercentSize(70, 100);
     studentsView.setDefaultElementStyle(defaultModalStyle());
     studentsView.setInheritStyle(true);
     
     container loansView({rightX, 0}, {rightW, tui.rows}, defaultModalStyle(), "Empréstimos Ativos");
+    loansView.setPercentPosition(30, 0);
+    loansView.setPercentSize(70, 100);
     loansView.setDefaultElementStyle(defaultModalStyle());
     loansView.setInheritStyle(true);
     
     container searchView({rightX, 0}, {rightW, tui.rows}, defaultModalStyle(), "Buscar Livros");
+    searchView.setPercentPosition(30, 0);
+    searchView.setPercentSize(70, 100);
     searchView.setDefaultElementStyle(defaultModalStyle());
     searchView.setInheritStyle(true);
     
@@ -86,12 +99,14 @@ void runTestUI(app::Database& db) {
     returnBookBtn.setPercentPosition(8, 92);
     
     //list views
-    std::vector<std::string> booksData = loadBooksFromDatabase(bookRepo);
     std::vector<std::string> studentsData = loadStudentsFromDatabase(studentRepo);
     std::vector<std::string> searchData = searchBooksFromDatabase(bookRepo, "");
     std::vector<RichListItem> loansData = loadLoansRichFromDatabase(loanRepo);
     
-    ListView booksList("", booksData, {0, 0}, rightW - 4, tui.rows - 4, 15);
+    // The catalogue can be large: the list reads only the rows it shows
+    BookListSource booksSource(bookRepo);
+    ListView booksList("", {}, {0, 0}, rightW - 4, tui.rows - 4, 15);
+    booksList.setSource(&booksSource);
     booksList.setPercentPosition(2, 5);
     booksList.setPercentW(96);
     booksList.setPercentH(90);
@@ -175,7 +190,7 @@ void runTestUI(app::Database& db) {
         currentView = ViewType::BOOKS;
         currentRightContainer = &booksView;
         actionsMenu.setRight(&booksView);
-        booksList.setItems(loadBooksFromDatabase(bookRepo));
+        booksList.reload();
     };
     
     viewStudentsBtn.onClickHandler = [&](element&, TUImanager&) {
@@ -232,7 +247,7 @@ void runTestUI(app::Database& db) {
         
     // Helper to refresh lists
     auto refreshLists = [&]() {
-        booksList.setItems(loadBooksFromDatabase(bookRepo));
+        booksList.reload();
         studentsList.setItems(loadStudentsFromDatabase(studentRepo));
         richLoansList.setItems(loadLoansRichFromDatabase(loanRepo));
     };
@@ -314,18 +329,13 @@ void runTestUI(app::Database& db) {
     tui.clearScreen(BACKGROUND);
     
     // ==================== MAIN EVENT LOOP ====================
+    // Notification expiry runs off a timer, so the loop sleeps in waitEvents until something
+    // happens: input, a resize, the timer, or a frame held back by the pacer coming due
+    int expiryTimer = -1;
     while (true) {
-        // Update notifications even without input (for auto-removal of expired ones)
-        // This will mark the notification area dirty if any were removed
-        notifications.update(tui);
+        bool input = tui.waitEvents(tui.hasDirty() ? tui.msUntilFrameDue() : -1);
         
-        if (!tui.hasDirty() && notifications.empty()) {
-            if (!tui.waitForInput(16)) {
-                continue;
-            }
-        }
-        
-        if (tui.pollInput()) break;
+        if (input && tui.pollInput()) break;
         
         // Render containers
         actionsMenu.render(tui);
@@ -343,9 +353,15 @@ void runTestUI(app::Database& db) {
         
         // Render notifications (highest z-index, top-right corner)
         notifications.render(tui);
+        if (!notifications.empty() && expiryTimer < 0) {
+            expiryTimer = tui.addTimer(notifications.msUntilNextExpiry(), [&](TUImanager& t) {
+                expiryTimer = -1;
+                notifications.update(t);
+            });
+        }
         
         tui.runEndOfFrame();
-        if (tui.hasDirty()) {
+        if (tui.hasDirty() && tui.frameDue()) {
             tui.render();
         }
     }
@@ -25,7 +25,7 @@ BookRegistrationModal::BookRegistrationModal(TUImanager& tui, app::repos::BookRe
     copiesInput = new InputBar("Cópias", {0, 0}, 15, 3);
     copiesInput->setPercentPosition(54, 38);
     copiesInput->setPercentW(38);
-    copiesInput->text = "1";
+    copiesInput->setText("1");
     
     isbnInput = new InputBar("ISBN", {0, 0}, 40, 3);
     isbnInput->setPercentPosition(8, 50);
@@ -68,11 +68,11 @@ BookRegistrationModal::~BookRegistrationModal() {
 
 void BookRegistrationModal::open(TUImanager& tui, container*) {
     isOpen_ = true;
-    titleInput->text.clear();
-    authorInput->text.clear();
-    yearInput->text.clear();
-    isbnInput->text.clear();
-    copiesInput->text = "1";
+    titleInput->setText("");
+    authorInput->setText("");
+    yearInput->setText("");
+    isbnInput->setText("");
+    copiesInput->setText("1");
     tui.focusContainer(modalContainer, 0);
 }
 
@@ -227,12 +227,12 @@ void BookEditModal::close(TUImanager& tui, container* returnTo) {
 }
 
 void BookEditModal::clearFields() {
-    idInput->text.clear();
-    titleInput->text.clear();
-    authorInput->text.clear();
-    yearInput->text.clear();
-    isbnInput->text.clear();
-    copiesInput->text.clear();
+    idInput->setText("");
+    titleInput->setText("");
+    authorInput->setText("");
+    yearInput->setText("");
+    isbnInput->setText("");
+    copiesInput->setText("");
     currentBookId = 0;
 }
 
@@ -264,11 +264,11 @@ void BookEditModal::handleLoad() {
     }
     
     currentBookId = bookOpt->id;
-    titleInput->text = bookOpt->title;
-    authorInput->text = bookOpt->author;
-    yearInput->text = bookOpt->published_year ? std::to_string(*bookOpt->published_year) : "";
-    isbnInput->text = bookOpt->isbn.value_or("");
-    copiesInput->text = std::to_string(bookOpt->copies_available);
+    titleInput->setText(bookOpt->title);
+    authorInput->setText(bookOpt->author);
+    yearInput->setText(bookOpt->published_year ? std::to_string(*bookOpt->published_year) : "");
+    isbnInput->setText(bookOpt->isbn.value_or(""));
+    copiesInput->setText(std::to_string(bookOpt->copies_available));
     setSuccess("Carregado: " + bookOpt->title);
 }
 
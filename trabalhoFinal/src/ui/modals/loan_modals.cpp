@@ -26,7 +26,7 @@ LoanCreationModal::LoanCreationModal(TUImanager& tui,
     dueDaysInput = new InputBar("Dias para devolução", {0, 0}, 40, 3);
     dueDaysInput->setPercentPosition(8, 50);
     dueDaysInput->setPercentW(84);
-    dueDaysInput->text = "14";
+    dueDaysInput->setText("14");
     
     // Buttons - vertical layout for proper navigation
     submitBtn = new Button("[ Confirmar ]", {0, 0}, 18, 3);
@@ -58,9 +58,9 @@ LoanCreationModal::~LoanCreationModal() {
 
 void LoanCreationModal::open(TUImanager& tui, container*) {
     isOpen_ = true;
-    studentRegInput->text.clear();
-    bookIdInput->text.clear();
-    dueDaysInput->text = "14";
+    studentRegInput->setText("");
+    bookIdInput->setText("");
+    dueDaysInput->setText("14");
     tui.focusContainer(modalContainer, 0);
 }
 
@@ -189,7 +189,7 @@ LoanReturnModal::~LoanReturnModal() {
 
 void LoanReturnModal::open(TUImanager& tui, container*) {
     isOpen_ = true;
-    loanIdInput->text.clear();
+    loanIdInput->setText("");
     tui.focusContainer(modalContainer, 0);
 }
 
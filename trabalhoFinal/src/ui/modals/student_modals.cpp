@@ -63,10 +63,10 @@ StudentRegistrationModal::~StudentRegistrationModal() {
 
 void StudentRegistrationModal::open(TUImanager& tui, container*) {
     isOpen_ = true;
-    nameInput->text.clear();
-    regNumberInput->text.clear();
-    emailInput->text.clear();
-    phoneInput->text.clear();
+    nameInput->setText("");
+    regNumberInput->setText("");
+    emailInput->setText("");
+    phoneInput->setText("");
     tui.focusContainer(modalContainer, 0);
 }
 
@@ -191,11 +191,11 @@ void StudentEditModal::close(TUImanager& tui, container* returnTo) {
 }
 
 void StudentEditModal::clearFields() {
-    searchInput->text.clear();
-    nameInput->text.clear();
-    regNumberInput->text.clear();
-    emailInput->text.clear();
-    phoneInput->text.clear();
+    searchInput->setText("");
+    nameInput->setText("");
+    regNumberInput->setText("");
+    emailInput->setText("");
+    phoneInput->setText("");
     currentStudentId = 0;
 }
 
@@ -225,10 +225,10 @@ void StudentEditModal::handleLoad() {
     }
     
     currentStudentId = studentOpt->id;
-    nameInput->text = studentOpt->name;
-    regNumberInput->text = studentOpt->registration_number;
-    emailInput->text = studentOpt->email.value_or("");
-    phoneInput->text = studentOpt->phone.value_or("");
+    nameInput->setText(studentOpt->name);
+    regNumberInput->setText(studentOpt->registration_number);
+    emailInput->setText(studentOpt->email.value_or(""));
+    phoneInput->setText(studentOpt->phone.value_or(""));
     setSuccess("Carregado: " + studentOpt->name);
 }
 
@@ -94,22 +94,47 @@ std::vector<std::string> loadStudentsFromDatabase(app::repos::StudentRepository&
     return studentStrings;
 }
 
-std::vector<std::string> loadBooksFromDatabase(app::repos::BookRepository& bookRepo) {
-    std::vector<std::string> bookStrings;
-    auto books = bookRepo.findAll();
-    
-    for (const auto& book : books) {
-        // Use hash-based ID for display (e.g., "BK-x7Kp2m")
-        std::string entry = "[" + book.hashId() + "] " + book.title + " - " + book.author;
-        entry += " (" + std::to_string(book.copies_available) + " disponíveis)";
-        bookStrings.push_back(entry);
+namespace {
+// "[BK-x7Kp2m] Title - Author (3 disponíveis)", with the hash-based ID shown to users
+void formatBookEntry(const app::models::Book& book, std::string& out) {
+    out.clear();
+    out += "[";
+    out += book.hashId();
+    out += "] ";
+    out += book.title;
+    out += " - ";
+    out += book.author;
+    out += " (";
+    out += std::to_string(book.copies_available);
+    out += " disponíveis)";
+}
+}
+
+int BookListSource::count() {
+    const int64_t n = repo.count();
+    empty = n == 0;
+    page.clear();
+    // An empty catalogue still shows one row saying so
+    return empty ? 1 : static_cast<int>(std::min<int64_t>(n, std::numeric_limits<int>::max()));
+}
+
+void BookListSource::prefetch(int first, int n) {
+    if (empty) return;
+    page = repo.findPage(first, n);
+    pageFirst = first;
+}
+
+void BookListSource::itemAt(int i, std::string& out) {
+    if (empty) {
+        out = "Nenhum livro registrado";
+        return;
     }
-    
-    if (bookStrings.empty()) {
-        bookStrings.push_back("Nenhum livro registrado");
+    if (i < pageFirst || i >= pageFirst + static_cast<int>(page.size())) prefetch(i, 1);
+    if (i < pageFirst || i >= pageFirst + static_cast<int>(page.size())) {
+        out.clear(); // the book went away since count()
+        return;
     }
-    
-    return bookStrings;
+    formatBookEntry(page[i - pageFirst], out);
 }
 
 std::vector<std::string> searchBooksFromDatabase(app::repos::BookRepository& bookRepo, const std::string& query) {
@@ -120,10 +145,8 @@ std::vector<std::string> searchBooksFromDatabase(app::repos::BookRepository& boo
         if (containsCaseInsensitive(book.title, query) ||
             containsCaseInsensitive(book.author, query) ||
             (book.isbn.has_value() && containsCaseInsensitive(*book.isbn, query))) {
-            // Use hash-based ID for display
-            std::string entry = "[" + book.hashId() + "] " + book.title + " - " + book.author;
-            entry += " (" + std::to_string(book.copies_available) + " disponíveis)";
-            bookStrings.push_back(entry);
+            bookStrings.emplace_back();
+            formatBookEntry(book, bookStrings.back());
         }
     }
 